@@ -10,7 +10,7 @@
 #ifndef EVOL_ACTION_H_
 #define EVOL_ACTION_H_
 
-#include "Lifeform.h"
+#include "LifeformStore.h"
 #include "Types.h"
 
 namespace evol {
@@ -22,11 +22,11 @@ namespace evol {
  */
 struct Action {
  public:
-  Action() = delete;
-  Action(Lifeform a, ActionType t) : actor(a), type(t) {}
+  Action() : actor(0), type(ActionType::NOTHING) {}
+  Action(LifeformIndex a, ActionType t) : actor(a), type(t) {}
 
   // Lifeform performing this action
-  Lifeform actor;
+  LifeformIndex actor;
   // The thing the lifeform wants to do
   ActionType type;
 };
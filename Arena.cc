@@ -10,79 +10,183 @@
 #include "Arena.h"
 
 #include <stdlib.h>  // abort()
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstdint>
+#include <utility>
 
 #include "ArenaBlock.h"
+#include "Checkpoint.h"
 #include "Coord.h"
+#include "Genome.h"
 #include "Lifeform.h"
+#include "LifeformStore.h"
+#include "Span.h"
 
 namespace evol {
 
 
-void Arena::AddLifeform(Lifeform lf, const Coord & c) {
-  lf->SetCoord(c);
-  grid_.At(c).AddLifeform(lf);
-  lifeforms_.push_back(lf);
+namespace {
+
+// Which of SensorWords::bits holds each sensor: its bit number
+constexpr unsigned kNorthWord = 0;
+constexpr unsigned kSouthWord = 1;
+constexpr unsigned kEastWord = 2;
+constexpr unsigned kWestWord = 3;
+constexpr unsigned kCrowdedWord = 4;
+constexpr unsigned kNeighborWord = 5;
+static_assert(kSensorNorth == 1 << kNorthWord && kSensorSouth == 1 << kSouthWord &&
+              kSensorEast == 1 << kEastWord && kSensorWest == 1 << kWestWord &&
+              kSensorCrowded == 1 << kCrowdedWord && kSensorNeighbor == 1 << kNeighborWord,
+              "sensor words must be in sensor bit order");
+
+
+/**
+ * Shifts one row of a bitboard by a square, wrapping round the arena's
+ * edge.  A row is width bits in words words, with the bits past width clear
+ * (and kept clear).
+ */
+class BoardRow {
+ public:
+  BoardRow(size_t words, Unit width)
+      : last_(words - 1),
+        top_bit_((width - 1) & 63),
+        tail_mask_(width & 63 ? (uint64_t(1) << (width & 63)) - 1 : ~uint64_t(0)) {}
+
+  /**
+   * Word i of the row shifted west, so each square has its east neighbour's
+   * bit.
+   */
+  uint64_t FromEast(const uint64_t * row, size_t i) const {
+    if (i < last_)
+      return (row[i] >> 1) | (row[i + 1] << 63);
+    return (row[i] >> 1) | ((row[0] & 1) << top_bit_);
+  }
+
+  /**
+   * Word i of the row shifted east, so each square has its west neighbour's
+   * bit.
+   */
+  uint64_t FromWest(const uint64_t * row, size_t i) const {
+    const uint64_t carry = i > 0 ? row[i - 1] >> 63 : (row[last_] >> top_bit_) & 1;
+    const uint64_t word = (row[i] << 1) | carry;
+    return i < last_ ? word : word & tail_mask_;
+  }
+
+ private:
+  size_t last_;
+  unsigned top_bit_;
+  uint64_t tail_mask_;
+};
+
+}  // namespace anon
+
+
+LifeformIndex Arena::AddLifeform(const Lifeform & lf, const Coord & c) {
+  LifeformIndex i = lifeforms_.Add(lf->Id(), lf->Gen(), lf->GetEnergy(), c, CellIndex(c),
+                                   genomes_.Intern(lf->GetDna()));
+  lifeforms_.SetBlockSlot(i, grid_.At(c).AddLifeform(i));
+  ++occupancy_.At(c);
+  return i;
+}
+
+
+LifeformIndex Arena::AddLifeform(uint64_t gen, GenomeRef genome, float energy,
+                                 const Coord & c) {
+  LifeformIndex i = lifeforms_.Add(next_id_, gen, energy, c, CellIndex(c), std::move(genome));
+  next_id_ += id_stride_;
+  lifeforms_.SetBlockSlot(i, grid_.At(c).AddLifeform(i));
+  ++occupancy_.At(c);
+  return i;
+}
+
+
+void Arena::MoveLifeform(LifeformIndex lf, const Coord & c) {
+  RemoveFromBlock(lf);
+  PlaceLifeform(lf, c);
+}
+
+
+void Arena::PlaceLifeform(LifeformIndex lf, const Coord & c) {
+  lifeforms_.SetCoord(lf, c, CellIndex(c));
+  lifeforms_.SetBlockSlot(lf, grid_.At(c).AddLifeform(lf));
+  ++occupancy_.At(c);
 }
 
 
-void Arena::MoveLifeform(Lifeform lf, const Coord & c) {
-  grid_.At(lf->GetCoord()).RemoveLifeform(lf);
-  lf->SetCoord(c);
-  grid_.At(c).AddLifeform(lf);
+void Arena::KillLifeform(LifeformIndex lf) {
+  if (!lifeforms_.Alive(lf)) {
+    return;
+  }
+  RemoveFromBlock(lf);
+  lifeforms_.SetKilled(lf);
+  dead_lifeforms_count_.fetch_add(1, std::memory_order_relaxed);
 }
 
 
 /**
- * Removes the lifeform from the Arena.  Returns the lifeform if it was
- * found, otherwise nullptr.
+ * Walk the candidates from the back, so every record swapped into a vacated
+ * slot comes from past the last dead one, and is alive.
  */
-Lifeform Arena::RemoveLifeform(const Lifeform & lf) {
-  Lifeform ret;
-
-  for (auto iter = lifeforms_.begin(); iter != lifeforms_.end(); ++iter) {
-    if (**iter == *lf) {
-      ret = *iter;
-      lifeforms_.erase(iter);
-      break;
+void Arena::ReapDeadLifeforms(Span<const LifeformIndex> candidates) {
+  for (size_t i = candidates.size(); i-- > 0; ) {
+    if (!lifeforms_.Alive(candidates[i])) {
+      RemoveFromStore(candidates[i]);
     }
   }
-  grid_.At(lf->GetCoord()).RemoveLifeform(lf);
-  lf->SetKilled();
-  dead_lifeforms_count_++;
-
-  return ret;
 }
 
 
 /**
  * Like KillLifeform(), except:
  *   - pick a lifeform at random
- *   - increment death counters
- *   - Return pointer to lifeform
+ *   - don't increment death counters
+ *   - Return a detached copy of the lifeform
  *
  * Returns nullptr if the arena was empty.
  */
 Lifeform Arena::RemoveRandomLifeform() {
-  Lifeform ret;
-
-  size_t numlf = lifeforms_.size();
+  size_t numlf = lifeforms_.Size();
   if (numlf < 1) {
     // Arena is empty
     return nullptr;
   }
 
-  auto victim = lifeforms_.begin() + Random::Int32(0, numlf - 1);
-  ret = *victim;
-  grid_.At((*victim)->GetCoord()).RemoveLifeform(*victim);
-  lifeforms_.erase(victim);
+  LifeformIndex victim = Random::Int32(0, numlf - 1);
+  Lifeform ret = lifeforms_.Get(victim);
+  RemoveFromBlock(victim);
+  RemoveFromStore(victim);
 
   return ret;
 }
 
 
-std::vector<LifeformImpl *> Arena::GetAdjacentLifeforms(const Coord &c) {
-  std::vector<LifeformImpl *> adjacent;
+void Arena::RemoveFromBlock(LifeformIndex lf) {
+  Coord c = lifeforms_.GetCoord(lf);
+  ArenaBlock & block = grid_.At(c);
+  uint32_t slot = lifeforms_.BlockSlot(lf);
+  assert(block.Lifeforms()[slot] == lf);
+  if (block.RemoveLifeformAt(slot)) {
+    // Another occupant took over the slot
+    lifeforms_.SetBlockSlot(block.Lifeforms()[slot], slot);
+  }
+  --occupancy_.At(c);
+}
+
+
+void Arena::RemoveFromStore(LifeformIndex lf) {
+  if (lifeforms_.SwapRemove(lf) && lifeforms_.Alive(lf)) {
+    // The last record now lives at lf; renumber it on its ArenaBlock.  (Dead
+    // records are already off the plane.)
+    grid_.At(lifeforms_.GetCoord(lf)).Lifeforms()[lifeforms_.BlockSlot(lf)] = lf;
+  }
+}
+
+
+std::array<Span<const LifeformIndex>, 8> Arena::GetAdjacentLifeforms(const Coord &c) const {
+  std::array<Span<const LifeformIndex>, 8> adjacent;
+  auto square = adjacent.begin();
 
   for (Unit xp = -1; xp <= 1; xp++) {
     for (Unit yp = -1; yp <= 1; yp++) {
@@ -90,9 +194,7 @@ std::vector<LifeformImpl *> Arena::GetAdjacentLifeforms(const Coord &c) {
         continue;
       }
       Coord t(c.x + xp, c.y + yp);
-      for (auto & lf : grid_.At(t).Lifeforms()) {
-        adjacent.push_back(lf.get());
-      }
+      *square++ = grid_.At(t).Lifeforms();
     }
   }
 
@@ -116,4 +218,160 @@ bool Arena::AdjacentLifeforms(const Coord &c) const {
 }
 
 
+/**
+ * The occupancy plane holds each square's head count, so a row of it packs
+ * straight into occupied and crowded bits.
+ */
+void Arena::UpdateOccupiedRows(Unit first_row, Unit end_row) {
+  const uint32_t * occupancy = occupancy_.Data();
+  for (Unit y = first_row; y < end_row; ++y) {
+    const uint32_t * row = occupancy + size_t(y) * width_;
+    for (size_t i = 0; i < row_words_; ++i) {
+      const Unit x0 = i * 64;
+      const Unit n = std::min<Unit>(64, width_ - x0);
+      uint64_t occupied = 0, crowded = 0;
+      for (Unit b = 0; b < n; ++b) {
+        occupied |= uint64_t(row[x0 + b] > 0) << b;
+        crowded |= uint64_t(row[x0 + b] > 1) << b;
+      }
+      occupied_[y * row_words_ + i] = occupied;
+      sensor_words_[y * row_words_ + i].bits[kCrowdedWord] = crowded;
+    }
+  }
+}
+
+
+/**
+ * Everything but crowding is the occupied board shifted a square, a row at a
+ * time.
+ */
+void Arena::UpdateSensorRows(Unit first_row, Unit end_row) {
+  const BoardRow rows(row_words_, width_);
+  for (Unit y = first_row; y < end_row; ++y) {
+    const uint64_t * here = &occupied_[y * row_words_];
+    const uint64_t * north = &occupied_[(y == 0 ? height_ - 1 : y - 1) * row_words_];
+    const uint64_t * south = &occupied_[(y + 1 == height_ ? 0 : y + 1) * row_words_];
+    SensorWords * out = &sensor_words_[y * row_words_];
+    for (size_t i = 0; i < row_words_; ++i) {
+      const uint64_t east = rows.FromEast(here, i);
+      const uint64_t west = rows.FromWest(here, i);
+      out[i].bits[kNorthWord] = north[i];
+      out[i].bits[kSouthWord] = south[i];
+      out[i].bits[kEastWord] = east;
+      out[i].bits[kWestWord] = west;
+      // IS_NEIGHBOR looks at all eight surrounding squares
+      out[i].bits[kNeighborWord] = east | west |
+          north[i] | rows.FromEast(north, i) | rows.FromWest(north, i) |
+          south[i] | rows.FromEast(south, i) | rows.FromWest(south, i);
+    }
+  }
+}
+
+
+void Arena::SaveCheckpoint(CheckpointWriter & out) const {
+  out.Put(width_);
+  out.Put(height_);
+  out.Put(next_id_);
+  out.Put(id_stride_);
+  out.Put(uint64_t(dead_lifeforms_count_));
+  out.PutArray(EnergyPlane());
+
+  std::vector<Elevation> elevations(NumCells());
+  for (size_t cell = 0; cell < elevations.size(); ++cell) {
+    elevations[cell] = grid_.Data()[cell].GetElevation();
+  }
+  out.PutArray(Span<const Elevation>(elevations));
+
+  out.Put(uint64_t(lifeforms_.Size()));
+  for (LifeformIndex lf = 0; lf < lifeforms_.Size(); ++lf) {
+    assert(lifeforms_.Alive(lf));
+    out.Put(lifeforms_.Id(lf));
+    out.Put(lifeforms_.Gen(lf));
+    out.Put(lifeforms_.GetEnergy(lf));
+    out.Put(lifeforms_.GetCoord(lf).x);
+    out.Put(lifeforms_.GetCoord(lf).y);
+    out.Put(lifeforms_.BlockSlot(lf));
+    out.PutDna(lifeforms_.GetDna(lf));
+  }
+}
+
+
+/**
+ * Lifeforms go back into the store in the order they were saved, then onto
+ * their squares in the slots they were saved in, so the occupant lists come
+ * out as they were rather than in store order.
+ */
+bool Arena::RestoreCheckpoint(CheckpointReader & in) {
+  assert(lifeforms_.Empty());
+
+  Unit width, height;
+  uint64_t dead;
+  if (!in.Get(&width) || !in.Get(&height) || !in.Get(&next_id_) || !in.Get(&id_stride_) ||
+      !in.Get(&dead)) {
+    return false;
+  }
+  if (width != width_ || height != height_) {
+    return in.Fail("arena size doesn't match the width and height settings");
+  }
+  if (id_stride_ == 0) {
+    return in.Fail("bad id sequence");
+  }
+  dead_lifeforms_count_ = dead;
+
+  std::vector<Energy> energy;
+  std::vector<Elevation> elevations;
+  if (!in.GetArray(&energy, NumCells()) || !in.GetArray(&elevations, NumCells())) {
+    return false;
+  }
+  if (energy.size() != NumCells() || elevations.size() != NumCells()) {
+    return in.Fail("arena planes are the wrong size");
+  }
+  std::copy(energy.begin(), energy.end(), energy_.Data());
+  for (size_t cell = 0; cell < elevations.size(); ++cell) {
+    grid_.Data()[cell].SetElevation(elevations[cell]);
+  }
+
+  uint64_t num_lifeforms;
+  if (!in.Get(&num_lifeforms)) {
+    return false;
+  }
+  if (num_lifeforms > in.Remaining()) {
+    return in.Fail("truncated");
+  }
+  for (uint64_t i = 0; i < num_lifeforms; ++i) {
+    uint64_t id, gen;
+    float lf_energy;
+    Unit x, y;
+    uint32_t slot;
+    Dna dna;
+    if (!in.Get(&id) || !in.Get(&gen) || !in.Get(&lf_energy) || !in.Get(&x) || !in.Get(&y) ||
+        !in.Get(&slot) || !in.GetDna(&dna)) {
+      return false;
+    }
+    if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+      return in.Fail("lifeform off the arena");
+    }
+    Coord c(x, y);
+    LifeformIndex lf = lifeforms_.Add(id, gen, lf_energy, c, CellIndex(c), genomes_.Intern(dna));
+    lifeforms_.SetBlockSlot(lf, slot);
+    ++occupancy_.At(c);
+  }
+
+  // Every square's slots must be filled exactly once
+  const LifeformIndex kEmpty = UINT32_MAX;
+  for (size_t cell = 0; cell < NumCells(); ++cell) {
+    grid_.Data()[cell].Lifeforms().assign(occupancy_.Data()[cell], kEmpty);
+  }
+  for (LifeformIndex lf = 0; lf < lifeforms_.Size(); ++lf) {
+    std::vector<LifeformIndex> & occupants = grid_.Data()[lifeforms_.GetCell(lf)].Lifeforms();
+    uint32_t slot = lifeforms_.BlockSlot(lf);
+    if (slot >= occupants.size() || occupants[slot] != kEmpty) {
+      return in.Fail("lifeforms' square slots don't add up");
+    }
+    occupants[slot] = lf;
+  }
+  return true;
+}
+
+
 }  // namespace evol
@@ -10,6 +10,8 @@
 #ifndef EVOL_ARENA_H_
 #define EVOL_ARENA_H_
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <algorithm>
 #include <memory>
@@ -17,13 +19,21 @@
 
 #include "ArenaBlock.h"
 #include "Coord.h"
+#include "DecisionTable.h"
+#include "Genome.h"
 #include "Grid.h"
 #include "Lifeform.h"
+#include "LifeformStore.h"
 #include "Random.h"
+#include "Span.h"
 
 namespace evol {
 
 
+class CheckpointReader;
+class CheckpointWriter;
+
+
 /**
  * The Arena is the grid which all lifeforms live upon.  It has methods for
  * accessing said lifeforms.
@@ -32,7 +42,18 @@ namespace evol {
 class Arena {
  public:
   Arena() = delete;
-  Arena(Unit w, Unit h) : width_(w), height_(h), dead_lifeforms_count_(0), grid_(Grid<ArenaBlock>(w, h)) {
+  Arena(Unit w, Unit h)
+      : width_(w),
+        height_(h),
+        dead_lifeforms_count_(0),
+        next_id_(1),
+        id_stride_(1),
+        grid_(w, h),
+        energy_(w, h, 1.0f),
+        occupancy_(w, h, 0),
+        row_words_((w + 63) / 64),
+        occupied_(row_words_ * h),
+        sensor_words_(row_words_ * h) {
     assert(w > 0 && h > 0);
   }
 
@@ -44,15 +65,29 @@ class Arena {
   int Height() const { return height_; }
 
   /**
-   * Returns the vector of living lifeforms.
+   * Number of squares on the arena, and conversion between Coords and dense
+   * row-major square indices.
    */
-  std::vector<Lifeform> Lifeforms() { return lifeforms_; }
-  const std::vector<Lifeform> Lifeforms() const { return lifeforms_; }
+  size_t NumCells() const { return grid_.Size(); }
+  size_t CellIndex(const Coord & c) const { return grid_.IndexOf(c); }
+  Coord CellCoord(size_t cell) const { return grid_.CoordOf(cell); }
+
+  /**
+   * Returns the store of living lifeforms.
+   */
+  LifeformStore & Lifeforms() { return lifeforms_; }
+  const LifeformStore & Lifeforms() const { return lifeforms_; }
+
+  /**
+   * Returns the genomes carried by the arena's lifeforms.
+   */
+  GenomePool & Genomes() { return genomes_; }
+  const GenomePool & Genomes() const { return genomes_; }
 
   /**
    * Return total number of live lifeforms.
    */
-  uint64_t NumLifeforms() const { return lifeforms_.size(); }
+  uint64_t NumLifeforms() const { return lifeforms_.Size(); }
 
   /**
    * Return total number of dead lifeforms.
@@ -60,52 +95,138 @@ class Arena {
   uint64_t NumDeadLifeforms() const { return dead_lifeforms_count_; }
 
   /**
-   * Add the given lifeform at the given x/y coord.
+   * Issue newborns the ids first, first + stride, first + 2 * stride, ...
+   * Arenas given distinct first ids below a common stride never issue the
+   * same id, so engines needn't share (or race over) a counter.
+   */
+  void SetIdSequence(uint64_t first, uint64_t stride) {
+    assert(first > 0 && stride > 0);
+    next_id_ = first;
+    id_stride_ = stride;
+  }
+
+  /**
+   * Add the given lifeform at the given x/y coord.  The lifeform keeps its
+   * id, generation, energy and Dna, which is interned in this arena's pool.
+   */
+  LifeformIndex AddLifeform(const Lifeform & lf, const Coord & c);
+
+  /**
+   * Add a newborn lifeform with the given generation, genome and energy at
+   * the given x/y coord.  The genome must be from this arena's pool.
    */
-  void AddLifeform(Lifeform lf, const Coord & c);
+  LifeformIndex AddLifeform(uint64_t gen, GenomeRef genome, float energy, const Coord & c);
 
   /**
-   * Returns Lifeforms at the given location.
+   * Returns view of the Lifeforms at the given location.  It is invalidated
+   * when lifeforms are added to, moved onto or removed from that location.
    */
-  std::vector<Lifeform> LifeformsAt(const Coord & c) { return grid_.At(c).Lifeforms(); }
-  const std::vector<Lifeform> LifeformsAt(const Coord & c) const { return grid_.At(c).Lifeforms(); }
+  Span<const LifeformIndex> LifeformsAt(const Coord & c) const { return grid_.At(c).Lifeforms(); }
 
   /**
    * Returns count of Lifeforms at the given location.
    */
-  uint64_t NumLifeformsAt(const Coord & c) { return grid_.At(c).Lifeforms().size(); }
+  uint64_t NumLifeformsAt(const Coord & c) const { return grid_.At(c).Lifeforms().size(); }
 
   /**
    * Move the lifeform to the given location.
    */
-  void MoveLifeform(Lifeform lf, const Coord & c);
+  void MoveLifeform(LifeformIndex lf, const Coord & c);
 
   /**
-   * Removes the given lifeform from the plane if it exists.  Returns the
-   * lifeform if it was found, else nullptr.
+   * The two halves of MoveLifeform(): take the lifeform off its square, then
+   * put it down on another.  Each only touches the one square (and its
+   * occupants), so threads working on disjoint squares can call them at
+   * once.
    */
-  Lifeform RemoveLifeform(const Lifeform & lf);
+  void LiftLifeform(LifeformIndex lf) { RemoveFromBlock(lf); }
+  void PlaceLifeform(LifeformIndex lf, const Coord & c);
+
+  /**
+   * Kill the given lifeform: it is taken off the plane immediately, but its
+   * record stays in the store (marked dead) until ReapDeadLifeforms().  Like
+   * LiftLifeform() it only touches the lifeform's own square.
+   */
+  void KillLifeform(LifeformIndex lf);
+
+  /**
+   * Remove dead lifeforms from the store, given every one of them (and
+   * possibly others still alive) in increasing order, so the store needn't
+   * be swept for them.  This renumbers survivors, so no LifeformIndex may be
+   * held across a call.
+   */
+  void ReapDeadLifeforms(Span<const LifeformIndex> candidates);
 
   /**
    * Remove a random lifeform.  Returns the lifeform if it was removed,
-   * else nullptr (this will happen if the arena is empty).
+   * else nullptr (this will happen if the arena is empty).  Like
+   * ReapDeadLifeforms(), this renumbers lifeforms.
    */
   Lifeform RemoveRandomLifeform();
 
   /**
-   * Returns all lifeforms in squares adjacent to the given Coord.
+   * Returns views of the lifeforms in each of the 8 squares adjacent to the
+   * given Coord.  Same caveats as LifeformsAt().
    */
-  std::vector<LifeformImpl *> GetAdjacentLifeforms(const Coord &);
+  std::array<Span<const LifeformIndex>, 8> GetAdjacentLifeforms(const Coord &) const;
 
   /**
    * Returns true if there are adjacent lifeforms.
    */
   bool AdjacentLifeforms(const Coord &c) const;
 
+  /**
+   * Rebuild the sensor bitboards which Sense() reads from the lifeforms'
+   * current positions.  Call it once lifeforms have moved (or come or gone)
+   * and before sensing; it costs a pass over the occupancy plane and a few
+   * word operations per 64 squares.
+   */
+  void UpdateSensorBoards() {
+    UpdateOccupiedRows(0, height_);
+    UpdateSensorRows(0, height_);
+  }
+
+  /**
+   * UpdateSensorBoards() in two steps over rows [first_row, end_row), so
+   * threads can each take a strip of rows.  Every strip's occupied rows must
+   * be done before any strip's sensor rows, which read the rows either side.
+   */
+  void UpdateOccupiedRows(Unit first_row, Unit end_row);
+  void UpdateSensorRows(Unit first_row, Unit end_row);
+
+  /**
+   * Return the state of the requested sensors for a lifeform at the given
+   * Coord, as of the last UpdateSensorBoards().  Sensors not in the mask
+   * are left clear.
+   */
+  SensorBits Sense(const Coord &c, SensorBits mask) const {
+    if (!mask)
+      return 0;  // Most Dna tests nothing
+    const SensorWords & words = sensor_words_[c.y * row_words_ + (c.x >> 6)];
+    const unsigned bit = c.x & 63;
+    SensorBits state = 0;
+    for (unsigned sensor = 0; sensor < kNumSensors; ++sensor) {
+      state |= ((words.bits[sensor] >> bit) & 1) << sensor;
+    }
+    return state & mask;
+  }
+
   /**
    * Return energy available at the given coordinate.
    */
-  Energy GetEnergy(const Coord &c) const { return grid_.At(c).GetEnergy(); }
+  Energy GetEnergy(const Coord &c) const { return energy_.At(c); }
+
+  /**
+   * Return the energy available at every square, in row-major order (see
+   * CellIndex()).
+   */
+  Span<const Energy> EnergyPlane() const { return Span<const Energy>(energy_.Data(), energy_.Size()); }
+
+  /**
+   * Return the number of lifeforms on every square, in row-major order.  This
+   * is kept up to date as lifeforms come and go, so reading it is free.
+   */
+  Span<const uint32_t> OccupancyPlane() const { return Span<const uint32_t>(occupancy_.Data(), occupancy_.Size()); }
 
   /**
    * Return elevation of the given coordinate.
@@ -120,16 +241,61 @@ class Arena {
                  Random::Int32(0, height_ - 1));
   }
 
+  /**
+   * Write everything about the arena to a checkpoint: the squares, the id
+   * sequence, and every lifeform in store order along with its slot on its
+   * square, so that RestoreCheckpoint() can rebuild the arena exactly.  Dead
+   * lifeforms must have been reaped.
+   */
+  void SaveCheckpoint(CheckpointWriter & out) const;
+
+  /**
+   * Load a newly made arena, of the same size, from a checkpoint.  Returns
+   * false (after complaining on stderr) if the checkpoint is bad.
+   */
+  bool RestoreCheckpoint(CheckpointReader & in);
+
  private:
+  // Take the lifeform off its ArenaBlock (but leave it in the store)
+  void RemoveFromBlock(LifeformIndex lf);
+
+  // Remove the lifeform's record from the store; it must already be off its
+  // ArenaBlock
+  void RemoveFromStore(LifeformIndex lf);
+
   Unit width_;
   Unit height_;
-  uint64_t dead_lifeforms_count_;
+  std::atomic<uint64_t> dead_lifeforms_count_;
+
+  // Next id to issue, and step between ids
+  uint64_t next_id_;
+  uint64_t id_stride_;
+
+  // Must outlive lifeforms_, which refers to its genomes
+  GenomePool genomes_;
 
-  std::vector<Lifeform> lifeforms_;
+  LifeformStore lifeforms_;
 
   // Grid of ArenaBlocks representing the "physical" space.
   Grid<ArenaBlock> grid_;
 
+  // Energy supplied per turn by each square
+  Grid<Energy> energy_;
+
+  // Number of lifeforms on each square; mirrors the sizes of the ArenaBlocks'
+  // lists so whole-arena passes don't have to visit them
+  Grid<uint32_t> occupancy_;
+
+  // Sensor bitboards: one bit per square, in rows of row_words_ words.  A
+  // SensorWords covers 64 squares of a row, with bits[s] set for the
+  // squares where a lifeform's sensor 1 << s reads true.
+  struct SensorWords {
+    uint64_t bits[kNumSensors];
+  };
+  size_t row_words_;
+  std::vector<uint64_t> occupied_;  // squares with any lifeform; scratch
+  std::vector<SensorWords> sensor_words_;
+
 };
 
 
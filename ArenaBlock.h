@@ -10,10 +10,12 @@
 #ifndef EVOL_ARENA_BLOCK_H_
 #define EVOL_ARENA_BLOCK_H_
 
-#include <list>
+#include <cassert>
+#include <cstdint>
 #include <utility>
+#include <vector>
 
-#include "Lifeform.h"
+#include "LifeformStore.h"
 
 namespace evol {
 
@@ -22,12 +24,15 @@ typedef float Energy;
 typedef int16_t Elevation;
 
 
+/**
+ * A single square of the Arena.  (The energy each square supplies lives in a
+ * separate flat plane on the Arena, since it is only ever swept in bulk.)
+ */
 class ArenaBlock {
  public:
-  ArenaBlock(Energy en = 1.0f, Elevation el = 0) : energy_(en), elevation_(el) {}
+  ArenaBlock(Elevation el = 0) : elevation_(el) {}
 
   ArenaBlock(ArenaBlock && other) {
-    energy_ = other.energy_;
     elevation_ = other.elevation_;
     lifeforms_ = std::move(other.lifeforms_);
     other.lifeforms_.clear();
@@ -39,14 +44,6 @@ class ArenaBlock {
   ArenaBlock & operator=(const ArenaBlock &other) = delete;
 
 
-  /**
-   * Get and set Energy value of the block
-   */
-  Energy GetEnergy() const { return energy_; }
-  void SetEnergy(Energy new_energy) {
-    energy_ = new_energy;
-  }
-
   /**
    * Get and set Elevation value of the block
    */
@@ -58,35 +55,39 @@ class ArenaBlock {
   /**
    * Returns reference to the ArenaBlock's list of lifeforms.
    */
-  std::vector<Lifeform> & Lifeforms() { return lifeforms_; }
-  const std::vector<Lifeform> & Lifeforms() const { return lifeforms_; }
+  std::vector<LifeformIndex> & Lifeforms() { return lifeforms_; }
+  const std::vector<LifeformIndex> & Lifeforms() const { return lifeforms_; }
 
   /**
-   * Adds the given Lifeform to the block.
+   * Adds the given Lifeform to the block.  Returns its slot in the block's
+   * list of lifeforms.
    */
-  Lifeform & AddLifeform(const Lifeform & lf) {
+  uint32_t AddLifeform(LifeformIndex lf) {
     lifeforms_.push_back(lf);
-    return lifeforms_.back();
+    return lifeforms_.size() - 1;
   }
 
   /**
-   * Removes the given lifeform from the block, if it was there.
+   * Removes the lifeform in the given slot by moving the last occupant into
+   * it.  Returns true if an occupant was moved, in which case it is now
+   * Lifeforms()[slot].
    */
-  void RemoveLifeform(const Lifeform & victim) {
-    for (auto iter = lifeforms_.begin(); iter != lifeforms_.end(); iter++) {
-      if (**iter == *victim) {
-        lifeforms_.erase(iter);
-        break;
-      }
+  bool RemoveLifeformAt(uint32_t slot) {
+    assert(slot < lifeforms_.size());
+    bool moved = slot != lifeforms_.size() - 1;
+    if (moved) {
+      lifeforms_[slot] = lifeforms_.back();
     }
+    lifeforms_.pop_back();
+    return moved;
   }
 
   /**
    * Returns true if the lifeform is in the block.
    */
-  bool HasLifeform(const Lifeform & lf) {
-    for (auto & occupant : lifeforms_) {
-      if (*occupant == *lf) {
+  bool HasLifeform(LifeformIndex lf) const {
+    for (auto occupant : lifeforms_) {
+      if (occupant == lf) {
         return true;
       }
     }
@@ -94,9 +95,8 @@ class ArenaBlock {
   }
 
  private:
-  Energy energy_;
   Elevation elevation_;
-  std::vector<Lifeform> lifeforms_;
+  std::vector<LifeformIndex> lifeforms_;
 };
 
 
@@ -0,0 +1,311 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "Asteroid.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "Checkpoint.h"
+#include "Random.h"
+
+namespace evol {
+
+
+Asteroid::Asteroid(const Config & config, unsigned num_engines, uint64_t seed)
+    : batch_(config.migration_batch),
+      capacity_(config.asteroid_size),
+      evict_on_full_(config.asteroid_evict_on_full),
+      nodes_(num_engines),
+      lockstep_(false),
+      arrived_(0),
+      exchanges_(0),
+      cancelled_(false) {
+  const std::string & topology = config.migration_topology;
+  const size_t capacity = capacity_;
+  const unsigned n = num_engines;
+
+  if (topology == "all") {
+    for (unsigned from = 0; from < n; ++from) {
+      for (unsigned to = 0; to < n; ++to) {
+        AddEdge(from, to, capacity);
+      }
+    }
+  } else if (topology == "ring") {
+    for (unsigned from = 0; from < n; ++from) {
+      AddEdge(from, (from + 1) % n, capacity);
+    }
+  } else if (topology == "torus") {
+    // As square a grid as n allows; a prime n makes a single column
+    unsigned cols = 1;
+    for (unsigned c = 1; c * c <= n; ++c) {
+      if (n % c == 0) {
+        cols = c;
+      }
+    }
+    unsigned rows = n / cols;
+    for (unsigned from = 0; from < n; ++from) {
+      unsigned x = from % cols, y = from / cols;
+      AddEdge(from, y * cols + (x + 1) % cols, capacity);
+      AddEdge(from, y * cols + (x + cols - 1) % cols, capacity);
+      AddEdge(from, (y + 1) % rows * cols + x, capacity);
+      AddEdge(from, (y + rows - 1) % rows * cols + x, capacity);
+    }
+  } else if (topology == "random") {
+    // Lay the engines out on a circle in random order, then link each to the
+    // engines a few random distances round from it.  Every engine gets
+    // degree edges out and degree in, with no repeats.
+    Xoshiro256 rng(seed);
+    std::vector<unsigned> order(n), steps;
+    for (unsigned i = 0; i < n; ++i) {
+      order[i] = i;
+      if (i > 0) {
+        steps.push_back(i);
+      }
+    }
+    for (unsigned i = n; i > 1; --i) {
+      std::swap(order[i - 1], order[rng.Bounded(i)]);
+    }
+    unsigned degree = std::min<unsigned>(config.migration_degree, steps.size());
+    for (unsigned i = 0; i < degree; ++i) {
+      std::swap(steps[i], steps[i + rng.Bounded(steps.size() - i)]);
+    }
+    for (unsigned i = 0; i < n; ++i) {
+      for (unsigned s = 0; s < degree; ++s) {
+        AddEdge(order[i], order[(i + steps[s]) % n], capacity);
+      }
+    }
+  } else {
+    abort();  // Config::Validate() checks the name
+  }
+}
+
+
+/**
+ * Self-loops and repeats are skipped; they crop up on small tori.
+ */
+void Asteroid::AddEdge(unsigned from, unsigned to, size_t capacity) {
+  if (from == to) {
+    return;
+  }
+  for (Edge * e : nodes_[from].out) {
+    if (e->to == to) {
+      return;
+    }
+  }
+  edges_.emplace_back(new Edge(from, to, capacity));
+  nodes_[from].out.push_back(edges_.back().get());
+  nodes_[to].in.push_back(edges_.back().get());
+}
+
+
+void Asteroid::Launch(unsigned engine, std::vector<Lifeform> & migrants) {
+  Node & node = nodes_[engine];
+  if (node.out.empty() || migrants.empty()) {
+    return;
+  }
+  Edge & edge = *node.out[node.next_out];
+  node.next_out = (node.next_out + 1) % node.out.size();
+
+  size_t sent = 0;
+  for (; sent < migrants.size(); ++sent) {
+    while (!edge.lifeforms.TryPush(std::move(migrants[sent]))) {
+      if (!evict_on_full_) {
+        break;
+      }
+      // Full: make room by dropping the oldest.  The destination may land it
+      // first, in which case there's room anyway.
+      Lifeform evicted;
+      if (edge.lifeforms.TryPop(&evicted)) {
+        edge.evicted.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    if (migrants[sent]) {
+      break;  // turned away
+    }
+  }
+
+  edge.launched.fetch_add(sent, std::memory_order_relaxed);
+  edge.turned_away.fetch_add(migrants.size() - sent, std::memory_order_relaxed);
+  migrants.erase(migrants.begin(), migrants.begin() + sent);
+}
+
+
+void Asteroid::Land(unsigned engine, std::vector<Lifeform> & landed) {
+  Node & node = nodes_[engine];
+  size_t wanted = batch_;
+  for (size_t tried = 0; tried < node.in.size() && wanted > 0; ++tried) {
+    Edge & edge = *node.in[node.next_in];
+    node.next_in = (node.next_in + 1) % node.in.size();
+
+    Lifeform lf;
+    size_t count = 0;
+    while (count < wanted && edge.lifeforms.TryPop(&lf)) {
+      landed.push_back(std::move(lf));
+      ++count;
+    }
+    edge.landed.fetch_add(count, std::memory_order_relaxed);
+    wanted -= count;
+  }
+}
+
+
+void Asteroid::Exchange(unsigned engine, std::vector<Lifeform> & migrants, bool land) {
+  std::unique_lock<std::mutex> ul(exchange_mutex_);
+  if (cancelled_) {
+    return;
+  }
+
+  parcels_[engine] = &migrants;
+  want_landing_[engine] = land;
+  if (++arrived_ == nodes_.size()) {
+    // Last one in does everybody's exchange; the rest are parked, so their
+    // parcels are ours to fill
+    for (unsigned i = 0; i < nodes_.size(); ++i) {
+      Launch(i, *parcels_[i]);
+    }
+    for (unsigned i = 0; i < nodes_.size(); ++i) {
+      if (want_landing_[i]) {
+        Land(i, *parcels_[i]);
+      }
+      parcels_[i] = nullptr;
+    }
+    arrived_ = 0;
+    ++exchanges_;
+    exchange_cv_.notify_all();
+  } else {
+    uint64_t exchange = exchanges_;
+    exchange_cv_.wait(ul, [&] { return exchanges_ != exchange || cancelled_; });
+  }
+}
+
+
+uint64_t Asteroid::NumLanded() const {
+  uint64_t total = 0;
+  for (auto & e : edges_) {
+    total += e->landed.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+
+uint64_t Asteroid::NumLaunched() const {
+  uint64_t total = 0;
+  for (auto & e : edges_) {
+    total += e->launched.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+
+uint64_t Asteroid::NumWaiting() const {
+  uint64_t total = 0;
+  for (auto & e : edges_) {
+    total += e->lifeforms.SizeApprox();
+  }
+  return total;
+}
+
+
+void Asteroid::SaveCheckpoint(CheckpointWriter & out) {
+  out.Put(uint64_t(edges_.size()));
+  std::vector<Lifeform> waiting;
+  for (auto & e : edges_) {
+    out.Put(e->from);
+    out.Put(e->to);
+    out.Put(e->launched.load());
+    out.Put(e->landed.load());
+    out.Put(e->evicted.load());
+    out.Put(e->turned_away.load());
+
+    waiting.clear();
+    Lifeform lf;
+    while (e->lifeforms.TryPop(&lf)) {
+      waiting.push_back(std::move(lf));
+    }
+    out.Put(uint64_t(waiting.size()));
+    for (auto & w : waiting) {
+      out.PutLifeform(w);
+      e->lifeforms.TryPush(std::move(w));  // can't fail: it all fit before
+    }
+  }
+
+  for (auto & node : nodes_) {
+    out.Put(uint64_t(node.next_out));
+    out.Put(uint64_t(node.next_in));
+  }
+}
+
+
+bool Asteroid::RestoreCheckpoint(CheckpointReader & in) {
+  const unsigned n = nodes_.size();
+  edges_.clear();
+  for (auto & node : nodes_) {
+    node.out.clear();
+    node.in.clear();
+  }
+
+  uint64_t num_edges;
+  if (!in.Get(&num_edges)) {
+    return false;
+  }
+  if (num_edges > uint64_t(n) * n) {
+    return in.Fail("too many migration edges");
+  }
+  for (uint64_t i = 0; i < num_edges; ++i) {
+    unsigned from, to;
+    uint64_t launched, landed, evicted, turned_away, num_waiting;
+    if (!in.Get(&from) || !in.Get(&to) || !in.Get(&launched) || !in.Get(&landed) ||
+        !in.Get(&evicted) || !in.Get(&turned_away) || !in.Get(&num_waiting)) {
+      return false;
+    }
+    if (from >= n || to >= n) {
+      return in.Fail("migration edge between unknown engines");
+    }
+    if (num_waiting > in.Remaining()) {
+      return in.Fail("truncated");
+    }
+    // The settings may have shrunk asteroid_size since; keep everyone
+    AddEdge(from, to, std::max<size_t>(capacity_, num_waiting));
+    if (edges_.size() != i + 1) {
+      return in.Fail("repeated migration edge");
+    }
+    Edge & edge = *edges_.back();
+    edge.launched = launched;
+    edge.landed = landed;
+    edge.evicted = evicted;
+    edge.turned_away = turned_away;
+
+    for (uint64_t w = 0; w < num_waiting; ++w) {
+      Lifeform lf;
+      if (!in.GetLifeform(&lf)) {
+        return false;
+      }
+      edge.lifeforms.TryPush(std::move(lf));
+    }
+  }
+
+  for (auto & node : nodes_) {
+    uint64_t next_out, next_in;
+    if (!in.Get(&next_out) || !in.Get(&next_in)) {
+      return false;
+    }
+    if (next_out >= std::max<size_t>(node.out.size(), 1) ||
+        next_in >= std::max<size_t>(node.in.size(), 1)) {
+      return in.Fail("bad migration edge cursor");
+    }
+    node.next_out = next_out;
+    node.next_in = next_in;
+  }
+  return true;
+}
+
+
+}  // namespace evol
@@ -10,84 +10,175 @@
 #ifndef EVOL_ASTEROID_H_
 #define EVOL_ASTEROID_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <vector>
 
+#include "BoundedQueue.h"
+#include "Config.h"
 #include "Lifeform.h"
-#include "Random.h"
 
 namespace evol {
 
 
+class CheckpointReader;
+class CheckpointWriter;
+
+
 /**
  * The "Asteroid" is a container for sharing lifeforms between engines; every so
- * often an engine will offer up one of its lifeforms to this queue, and every
- * so often an engine will grab a lifeform back.  This encourages more rapid
- * development between arenas.
+ * often an engine will offer up some of its lifeforms, and every so often an
+ * engine will grab some back.  This encourages more rapid development between
+ * arenas.
  *
  * The analogy is to an asteroid which may (or may not) have brought life to the
  * Earth (panspermia).
+ *
+ * There is really one asteroid per edge of a migration graph between the
+ * engines (the config's migration_topology), each a lock-free ring which only
+ * its source engine launches onto and only its destination engine lands
+ * from:
+ *
+ *   all     every engine to every other (the classic fully-mixed islands)
+ *   ring    engine i to engine i + 1, wrapping
+ *   torus   engines on a 2D grid, each to its 4 wrapped neighbours
+ *   random  a random graph where every engine has migration_degree edges
+ *           out and as many in
+ *
+ * Engines launch onto their outgoing edges in turn, and land from their
+ * incoming edges in turn, migration_batch lifeforms at a time.  Launching,
+ * landing and reading the counters never take a lock; only lockstep
+ * Exchange() does, to gather the engines together.
  */
 class Asteroid {
  public:
-  Asteroid(unsigned max_size) : max_size_(max_size), landed_(0), launched_(0) {
-    lifeforms_.reserve(max_size_);
-  }
+  /**
+   * One edge of the migration graph and its counters.
+   */
+  struct Edge {
+    Edge(unsigned from, unsigned to, size_t capacity)
+        : from(from), to(to), lifeforms(capacity), launched(0), landed(0), evicted(0),
+          turned_away(0) {}
+
+    const unsigned from;
+    const unsigned to;
+    BoundedQueue<Lifeform> lifeforms;
+
+    std::atomic<uint64_t> launched;
+    std::atomic<uint64_t> landed;
+    std::atomic<uint64_t> evicted;      // dropped from a full edge for a newcomer
+    std::atomic<uint64_t> turned_away;  // sent home from a full edge
+  };
 
   /**
-   * Put the given lifeform on the asteroid.
+   * Build the graph the config asks for between num_engines engines.  The
+   * random topology is drawn from seed.
    */
-  void LaunchLifeform(Lifeform lf) {
-    std::lock_guard<std::mutex> lg(lifeforms_mutex_);
-
-    if (lifeforms_.size() >= max_size_) {
-      // Vector is full, just overwrite a random lifeform.
-      lifeforms_[Random::Int32(0, lifeforms_.size() - 1)] = lf;
-    } else {
-      lifeforms_.push_back(lf);
-    }
-    ++launched_;
-  }
+  Asteroid(const Config & config, unsigned num_engines, uint64_t seed);
 
   /**
-   * Land a random lifeform from the asteroid.  Returns the lifeform, or
-   * nullptr if the asteroid is empty.
+   * Launch the given migrants onto the engine's next outgoing edge.  Any
+   * that don't fit (when the config doesn't evict from full edges), or which
+   * have nowhere to go, are left in migrants for the engine to take back.
    */
-  Lifeform LandLifeform() {
-    std::lock_guard<std::mutex> lg(lifeforms_mutex_);
-    Lifeform lf{nullptr};
-
-    if (!lifeforms_.empty()) {
-      auto lf_iter = lifeforms_.begin() + Random::Int32(0, lifeforms_.size() - 1);
-      lf = *lf_iter;
-      lifeforms_.erase(lf_iter);
-      ++landed_;
-    }
-
-    return lf;
-  }
+  void Launch(unsigned engine, std::vector<Lifeform> & migrants);
 
-  uint32_t NumLanded() {
-    std::lock_guard<std::mutex> lg(lifeforms_mutex_);
-    return landed_;
-  }
-  uint32_t NumLaunched() {
-    std::lock_guard<std::mutex> lg(lifeforms_mutex_);
-    return launched_;
+  /**
+   * Land up to migration_batch lifeforms bound for the given engine, taking
+   * its incoming edges in turn, and append them to landed.
+   */
+  void Land(unsigned engine, std::vector<Lifeform> & landed);
+
+  /**
+   * Switch to lockstep mode: rather than launching and landing whenever they
+   * like, engines meet in Exchange().
+   */
+  void SetLockstep() {
+    std::lock_guard<std::mutex> lg(exchange_mutex_);
+    parcels_.assign(nodes_.size(), nullptr);
+    want_landing_.assign(nodes_.size(), false);
+    lockstep_ = true;
   }
-  uint32_t NumWaiting() {
-    std::lock_guard<std::mutex> lg(lifeforms_mutex_);
-    return lifeforms_.size();
+  bool Lockstep() const { return lockstep_; }
+
+  /**
+   * Lockstep launch and land.  Every engine calls this on the same turns,
+   * with the migrants it is launching (maybe none) and whether it wants some
+   * landed.  Once all have arrived, launches are done in engine order, then
+   * landings in engine order, so the result depends only on what was offered
+   * and not on thread timing.  Returns with migrants holding those landed
+   * plus any launched migrants sent home, or untouched if Cancel() was
+   * called.
+   */
+  void Exchange(unsigned engine, std::vector<Lifeform> & migrants, bool land);
+
+  /**
+   * Release any engines waiting in Exchange(), and make future calls return
+   * immediately.  Called at shutdown, when engines no longer stop on the
+   * same turn.
+   */
+  void Cancel() {
+    std::lock_guard<std::mutex> lg(exchange_mutex_);
+    cancelled_ = true;
+    exchange_cv_.notify_all();
   }
 
- private:
-  const unsigned max_size_;
-  std::mutex lifeforms_mutex_;
-  std::vector<Lifeform> lifeforms_;
+  /**
+   * The edges of the migration graph, for their counters.
+   */
+  size_t NumEdges() const { return edges_.size(); }
+  const Edge & GetEdge(size_t i) const { return *edges_[i]; }
+
+  /**
+   * Totals over all edges; cheap enough to poll every frame.
+   */
+  uint64_t NumLanded() const;
+  uint64_t NumLaunched() const;
+  uint64_t NumWaiting() const;
+
+  /**
+   * Write the migration graph, its counters and the lifeforms in transit to
+   * a checkpoint.  No engine may be launching or landing meanwhile; each
+   * edge is emptied and refilled in the same order to get at its lifeforms.
+   */
+  void SaveCheckpoint(CheckpointWriter & out);
 
-  uint32_t landed_;
-  uint32_t launched_;
+  /**
+   * Replace the migration graph and everything on it with a checkpoint's.
+   * The graph must be for as many engines as this one.  Returns false (after
+   * complaining on stderr) if the checkpoint is bad.
+   */
+  bool RestoreCheckpoint(CheckpointReader & in);
+
+ private:
+  // Edges in and out of an engine, and the next of each to use
+  struct Node {
+    std::vector<Edge *> out;
+    std::vector<Edge *> in;
+    size_t next_out = 0;
+    size_t next_in = 0;
+  };
+
+  void AddEdge(unsigned from, unsigned to, size_t capacity);
+
+  const size_t batch_;
+  const size_t capacity_;   // of each edge
+  const bool evict_on_full_;
+  std::vector<std::unique_ptr<Edge>> edges_;
+  std::vector<Node> nodes_;
+
+  // Lockstep state; one slot per engine
+  std::mutex exchange_mutex_;
+  bool lockstep_;
+  unsigned arrived_;
+  uint64_t exchanges_;
+  bool cancelled_;
+  std::condition_variable exchange_cv_;
+  std::vector<std::vector<Lifeform> *> parcels_;
+  std::vector<bool> want_landing_;
 };
 
 
@@ -0,0 +1,242 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+// evol-bench: opcode-level microbenchmark of Dna execution.  For Dna made
+// mostly of one kind of opcode (and for random Dna), measures the reference
+// interpreter, DecisionTable::Evaluate(), and compares compiling a
+// DecisionTable by evaluating each sensor state in turn with compiling it
+// the way the engine does.  Then compares reading every IS_* sensor square
+// by square with reading the arena's sensor bitboards.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "Coord.h"
+#include "DecisionTable.h"
+#include "Dna.h"
+#include "Random.h"
+#include "Types.h"
+
+using namespace evol;
+
+
+namespace {
+
+// Length of each benchmarked Dna sequence
+constexpr size_t kDnaLength = 64;
+
+// Aim for at least this long per measurement
+constexpr double kMinSeconds = 0.2;
+
+// Arena for the sensor benchmark, and lifeforms per square on it
+constexpr Unit kArenaSize = 256;
+constexpr double kArenaDensity = 0.5;
+
+// Keeps results alive so the work isn't optimized away
+volatile unsigned sink;
+
+
+struct Case {
+  std::string name;
+  std::vector<Dna> dnas;
+};
+
+
+/**
+ * Dna made of the given pattern repeated out to kDnaLength - 1, then a final
+ * move.
+ */
+Dna Repeat(const std::vector<OpCode> & pattern) {
+  Dna dna;
+  while (dna.size() + pattern.size() < kDnaLength) {
+    for (OpCode opcode : pattern) {
+      dna.push_back(opcode);
+    }
+  }
+  dna.push_back(OpCode::FINAL_MOVE_WEST);
+  return dna;
+}
+
+
+std::vector<Case> MakeCases() {
+  std::vector<Case> cases;
+  cases.push_back(Case{"NOP", {Repeat({OpCode::NOP})}});
+  cases.push_back(Case{"IS_*", {Repeat({OpCode::IS_NORTH_OCCUPIED, OpCode::IS_CROWDED})}});
+  cases.push_back(Case{"IS_* + CJMP1",
+                       {Repeat({OpCode::IS_NORTH_OCCUPIED, OpCode::CJMP1, OpCode::NOP})}});
+  cases.push_back(Case{"JMP1", {Repeat({OpCode::JMP1, OpCode::APOPTOSIS})}});
+  cases.push_back(Case{"CJMP1", {Repeat({OpCode::IS_EAST_OCCUPIED, OpCode::CJMP1,
+                                         OpCode::JMP1, OpCode::NOP, OpCode::CJMP1,
+                                         OpCode::NOP})}});
+
+  // Random Dna, with final moves left out so most of it gets run
+  Xoshiro256 rng(1);
+  Case random{"random", {}};
+  for (int i = 0; i < 64; ++i) {
+    Dna dna(kDnaLength);
+    for (auto & opcode : dna) {
+      do {
+        opcode = static_cast<OpCode>(rng.Bounded(kOpcodeEnd + 1));
+      } while (opcode >= OpCode::FINAL_MOVE_NORTH || opcode == OpCode::APOPTOSIS);
+    }
+    random.dnas.push_back(dna);
+  }
+  cases.push_back(random);
+  return cases;
+}
+
+
+/**
+ * Returns nanoseconds per call of f(), which should do work_per_call units
+ * of work, per unit.
+ */
+template <typename F>
+double Measure(F f, size_t work_per_call) {
+  typedef std::chrono::steady_clock Clock;
+  size_t calls = 1;
+  for (;;) {
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+      f();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (seconds >= kMinSeconds) {
+      return seconds * 1e9 / (calls * work_per_call);
+    }
+    calls *= 2;
+  }
+}
+
+
+/**
+ * Compile a table the old way: evaluate the Dna directly in every state
+ * built from the sensors it mentions, copying the rest.
+ */
+unsigned CompileByEvaluate(const Dna & dna) {
+  SensorBits sensors = 0;
+  for (auto opcode : dna) {
+    sensors |= OpcodeSensor(opcode);
+  }
+  ActionType decisions[kNumSensorStates];
+  for (unsigned state = 0; state < kNumSensorStates; ++state) {
+    if (state & ~sensors) {
+      decisions[state] = decisions[state & sensors];
+    } else {
+      decisions[state] = DecisionTable::Evaluate(dna, state);
+    }
+  }
+  return static_cast<unsigned>(decisions[0]);
+}
+
+
+
+/**
+ * Read every sensor square by square.
+ */
+SensorBits SenseSquares(const Arena & arena, const Coord & c) {
+  SensorBits state = 0;
+  if (arena.NumLifeformsAt(c.North()) > 0)
+    state |= kSensorNorth;
+  if (arena.NumLifeformsAt(c.South()) > 0)
+    state |= kSensorSouth;
+  if (arena.NumLifeformsAt(c.East()) > 0)
+    state |= kSensorEast;
+  if (arena.NumLifeformsAt(c.West()) > 0)
+    state |= kSensorWest;
+  if (arena.NumLifeformsAt(c) > 1)
+    state |= kSensorCrowded;
+  if (arena.AdjacentLifeforms(c))
+    state |= kSensorNeighbor;
+  return state;
+}
+
+
+void BenchSensors() {
+  Coord::SetGlobalBounds(kArenaSize, kArenaSize);
+  Arena arena(kArenaSize, kArenaSize);
+  Xoshiro256 rng(2);
+  {
+    GenomeRef genome = arena.Genomes().Intern(Dna{OpCode::FINAL_MOVE_RANDOM});
+    const unsigned lifeforms = kArenaSize * kArenaSize * kArenaDensity;
+    for (unsigned i = 0; i < lifeforms; ++i) {
+      arena.AddLifeform(0, genome, 1.0f, Coord(rng.Bounded(kArenaSize), rng.Bounded(kArenaSize)));
+    }
+  }
+  Span<const Coord> coords = arena.Lifeforms().Coords();
+
+  double squares = Measure([&]() {
+    unsigned acc = 0;
+    for (const Coord & c : coords) {
+      acc += SenseSquares(arena, c);
+    }
+    sink = acc;
+  }, coords.size());
+  // Rebuilding the boards is part of each turn's cost
+  double boards = Measure([&]() {
+    arena.UpdateSensorBoards();
+    unsigned acc = 0;
+    for (const Coord & c : coords) {
+      acc += arena.Sense(c, kNumSensorStates - 1);
+    }
+    sink = acc;
+  }, coords.size());
+
+  printf("\n%ux%u arena, %zu lifeforms; ns per lifeform to read all sensors\n",
+         kArenaSize, kArenaSize, coords.size());
+  printf("%-14s %10s %10s %8s\n", "", "squares", "bitboards", "speedup");
+  printf("%-14s %10.2f %10.2f %7.1fx\n", "IS_*", squares, boards, squares / boards);
+}
+
+}  // namespace anon
+
+
+int main() {
+  printf("Dna length %zu; evaluate is ns per sensor state, compiles are ns per table\n",
+         kDnaLength);
+  printf("%-14s %10s %14s %10s %8s\n", "case", "evaluate", "compile(eval)", "compile",
+         "speedup");
+
+  for (const Case & c : MakeCases()) {
+    double evaluate = Measure([&]() {
+      unsigned acc = 0;
+      for (const Dna & dna : c.dnas) {
+        for (unsigned state = 0; state < kNumSensorStates; ++state) {
+          acc += static_cast<unsigned>(DecisionTable::Evaluate(dna, state));
+        }
+      }
+      sink = acc;
+    }, c.dnas.size() * kNumSensorStates);
+
+    double compile_evaluate = Measure([&]() {
+      unsigned acc = 0;
+      for (const Dna & dna : c.dnas) {
+        acc += CompileByEvaluate(dna);
+      }
+      sink = acc;
+    }, c.dnas.size());
+    double compile = Measure([&]() {
+      unsigned acc = 0;
+      for (const Dna & dna : c.dnas) {
+        DecisionTable t(dna);
+        acc += static_cast<unsigned>(t.Lookup(0));
+      }
+      sink = acc;
+    }, c.dnas.size());
+
+    printf("%-14s %10.2f %14.1f %10.1f %7.1fx\n", c.name.c_str(), evaluate, compile_evaluate,
+           compile, compile_evaluate / compile);
+  }
+
+  BenchSensors();
+  return 0;
+}
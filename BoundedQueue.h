@@ -0,0 +1,131 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_BOUNDED_QUEUE_H_
+#define EVOL_BOUNDED_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+
+namespace evol {
+
+
+/**
+ * A fixed-capacity FIFO which any number of threads may push to and pop from
+ * at once without taking a lock (after Dmitry Vyukov's bounded MPMC queue).
+ *
+ * Each slot carries a sequence number saying whose turn it is: a pusher
+ * claims position p by moving the tail on from p and may fill the slot once
+ * its sequence is 2p; it then sets the sequence to 2p + 1, which hands the
+ * slot to the popper claiming position p.  That popper empties it and sets
+ * the sequence to 2(p + capacity), ready for the pusher one lap later.
+ * Neither side ever waits on the other: a full or empty queue just fails the
+ * call.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(capacity), slots_(new Slot[capacity]), head_(0), tail_(0) {
+    if (capacity == 0) {
+      abort();
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+      slots_[i].sequence.store(2 * i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue & operator=(const BoundedQueue &) = delete;
+
+  size_t Capacity() const { return capacity_; }
+
+  /**
+   * Append value, unless the queue is full.  value is only moved from if
+   * this returns true.
+   */
+  bool TryPush(T && value) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot & slot = slots_[pos % capacity_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      intptr_t lap = intptr_t(sequence) - intptr_t(2 * pos);
+      if (lap == 0) {
+        // Slot is free for position pos; claim it if nobody beat us to it
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          slot.value = std::move(value);
+          slot.sequence.store(2 * pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lap < 0) {
+        // Still holds the value pushed a lap ago
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Move the oldest value into *value, unless the queue is empty.
+   */
+  bool TryPop(T * value) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot & slot = slots_[pos % capacity_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      intptr_t lap = intptr_t(sequence) - intptr_t(2 * pos + 1);
+      if (lap == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          *value = std::move(slot.value);
+          slot.value = T();
+          slot.sequence.store(2 * (pos + capacity_), std::memory_order_release);
+          return true;
+        }
+      } else if (lap < 0) {
+        // Nothing pushed at this position yet
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Number of values in the queue.  Only a snapshot if other threads are
+   * pushing and popping.
+   */
+  size_t SizeApprox() const {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  const size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Next positions to pop and push, on their own cache lines so poppers and
+  // pushers don't slow each other down
+  alignas(64) std::atomic<size_t> head_;
+  alignas(64) std::atomic<size_t> tail_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_BOUNDED_QUEUE_H_
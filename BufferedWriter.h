@@ -0,0 +1,138 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_BUFFERED_WRITER_H_
+#define EVOL_BUFFERED_WRITER_H_
+
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace evol {
+
+
+/**
+ * Appends text or binary data to a fixed buffer and writes it out each time it
+ * fills, so output costs one fwrite() per buffer rather than per value.
+ */
+class BufferedWriter {
+ public:
+  explicit BufferedWriter(FILE *file) : file_(file), used_(0), ok_(true) {}
+  ~BufferedWriter() { Flush(); }
+
+  void Put(const char *s, size_t n) {
+    if (used_ + n > sizeof(buffer_)) {
+      Flush();
+      if (n > sizeof(buffer_)) {
+        Write(s, n);
+        return;
+      }
+    }
+    memcpy(buffer_ + used_, s, n);
+    used_ += n;
+  }
+
+  void Put(const char *s) { Put(s, strlen(s)); }
+
+  /**
+   * Append the bytes of a trivially copyable value, as laid out in memory.
+   */
+  template <typename T>
+  void PutRaw(const T & v) {
+    Put(reinterpret_cast<const char *>(&v), sizeof(v));
+  }
+
+  /**
+   * Append text for a number.
+   */
+  void Put(uint64_t v) {
+    char digits[20];
+    char *p = digits + sizeof(digits);
+    do {
+      *--p = '0' + v % 10;
+      v /= 10;
+    } while (v != 0);
+    Put(p, digits + sizeof(digits) - p);
+  }
+
+  void Put(float v) {
+    // 9 significant digits reads back as the same float.  JSON has no
+    // infinities or NaNs.
+    if (!std::isfinite(v)) {
+      Put("null");
+      return;
+    }
+    char text[32];
+    Put(text, snprintf(text, sizeof(text), "%.9g", v));
+  }
+
+  void Flush() {
+    Write(buffer_, used_);
+    used_ = 0;
+  }
+
+  // False once any write has failed
+  bool Ok() const { return ok_; }
+
+ private:
+  void Write(const char *s, size_t n) {
+    if (n > 0 && fwrite(s, 1, n, file_) != n) {
+      ok_ = false;
+    }
+  }
+
+  FILE *file_;
+  char buffer_[1 << 16];
+  size_t used_;
+  bool ok_;
+};
+
+
+/**
+ * Create filename with whatever write(BufferedWriter &) puts, all at once: the
+ * data goes to a temporary file which is renamed over filename only when
+ * complete, so readers never see half of it.  Returns false (after
+ * complaining on stderr) if the file couldn't be written, in which case any
+ * previous version is left alone.
+ */
+template <typename Fn>
+bool WriteFileAtomically(const std::string & filename, Fn write) {
+  const std::string temp_filename = filename + ".tmp";
+  FILE *file = fopen(temp_filename.c_str(), "wb");
+  if (file == nullptr) {
+    fprintf(stderr, "Can't write %s: %s\n", temp_filename.c_str(), strerror(errno));
+    return false;
+  }
+
+  bool ok;
+  {
+    BufferedWriter out(file);
+    write(out);
+    out.Flush();
+    ok = out.Ok();
+  }
+  ok = fclose(file) == 0 && ok;
+
+  if (ok && rename(temp_filename.c_str(), filename.c_str()) != 0) {
+    ok = false;
+  }
+  if (!ok) {
+    fprintf(stderr, "Can't write %s: %s\n", filename.c_str(), strerror(errno));
+    remove(temp_filename.c_str());
+  }
+  return ok;
+}
+
+
+}  // namespace evol
+#endif  // EVOL_BUFFERED_WRITER_H_
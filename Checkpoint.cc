@@ -0,0 +1,160 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "Checkpoint.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "Asteroid.h"
+#include "Coord.h"
+#include "EvolEngine.h"
+
+namespace evol {
+
+
+void CheckpointWriter::PutLifeform(const Lifeform & lf) {
+  Put(lf->Id());
+  Put(lf->Gen());
+  Put(lf->GetEnergy());
+  Put(uint8_t(lf->Alive()));
+  Put(lf->GetCoord().x);
+  Put(lf->GetCoord().y);
+  PutDna(lf->GetDna());
+}
+
+
+bool CheckpointReader::Open(const std::string & filename) {
+  filename_ = filename;
+  data_.clear();
+  pos_ = 0;
+  ok_ = false;
+
+  std::unique_ptr<FILE, int (*)(FILE *)> file(fopen(filename.c_str(), "rb"), fclose);
+  if (!file) {
+    fprintf(stderr, "Can't open %s: %s\n", filename.c_str(), strerror(errno));
+    return false;
+  }
+  char buf[1 << 16];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), file.get())) > 0) {
+    data_.insert(data_.end(), buf, buf + n);
+  }
+  if (ferror(file.get())) {
+    fprintf(stderr, "Can't read %s: %s\n", filename.c_str(), strerror(errno));
+    return false;
+  }
+
+  ok_ = true;
+  if (!Get(&header_)) {
+    return false;
+  }
+  if (memcmp(header_.magic, kCheckpointMagic, sizeof(header_.magic)) != 0)
+    return Fail("not a checkpoint file");
+  if (header_.byte_order != kCheckpointByteOrder)
+    return Fail("written on a machine of different byte order");
+  if (header_.version != kCheckpointVersion)
+    return Fail("unsupported checkpoint version");
+  if (header_.num_engines < 1)
+    return Fail("no engines");
+  return true;
+}
+
+
+bool CheckpointReader::GetString(std::string *s) {
+  std::vector<char> chars;
+  if (!GetArray(&chars, data_.size())) {
+    return false;
+  }
+  s->assign(chars.begin(), chars.end());
+  return true;
+}
+
+
+bool CheckpointReader::GetDna(Dna *dna) {
+  if (!GetArray(dna, data_.size())) {
+    return false;
+  }
+  for (OpCode opcode : *dna) {
+    if (opcode >= OpCode::END) {
+      return Fail("bad opcode");
+    }
+  }
+  return true;
+}
+
+
+bool CheckpointReader::GetLifeform(Lifeform *lf) {
+  uint64_t id, gen;
+  float energy;
+  uint8_t alive;
+  Unit x, y;
+  Dna dna;
+  if (!Get(&id) || !Get(&gen) || !Get(&energy) || !Get(&alive) || !Get(&x) || !Get(&y) ||
+      !GetDna(&dna)) {
+    return false;
+  }
+  *lf = std::make_shared<LifeformImpl>(id, gen, alive != 0, energy, Coord(x, y), dna);
+  return true;
+}
+
+
+bool CheckpointReader::Fail(const char *error) {
+  if (ok_) {
+    fprintf(stderr, "Bad checkpoint %s: %s\n", filename_.c_str(), error);
+  }
+  ok_ = false;
+  return false;
+}
+
+
+bool CheckpointReader::Done() {
+  if (ok_ && pos_ != data_.size()) {
+    Fail("unexpected data at end");
+  }
+  return ok_;
+}
+
+
+bool CheckpointReader::Need(uint64_t bytes) {
+  if (!ok_) {
+    return false;
+  }
+  if (bytes > data_.size() - pos_) {
+    return Fail("truncated");
+  }
+  return true;
+}
+
+
+bool WriteCheckpoint(const std::string & filename, const Config & config,
+                     std::vector<EvolEngine> & engines, Asteroid & asteroid) {
+  CheckpointHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+  header.byte_order = kCheckpointByteOrder;
+  header.version = kCheckpointVersion;
+  header.num_engines = engines.size();
+  header.flags = asteroid.Lockstep() ? uint32_t(CheckpointHeader::LOCKSTEP) : 0;
+
+  return WriteFileAtomically(filename, [&](BufferedWriter & buffer) {
+    CheckpointWriter out(buffer);
+    out.Put(header);
+    out.PutString(config.ToString());
+    asteroid.SaveCheckpoint(out);
+    for (auto & engine : engines) {
+      engine.SaveCheckpoint(out);
+    }
+  });
+}
+
+
+}  // namespace evol
@@ -0,0 +1,204 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_CHECKPOINT_H_
+#define EVOL_CHECKPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "BufferedWriter.h"
+#include "Config.h"
+#include "Dna.h"
+#include "Lifeform.h"
+#include "Span.h"
+#include "Types.h"
+
+namespace evol {
+
+
+class Asteroid;
+class EvolEngine;
+
+
+/**
+ * Checkpoint format: everything needed to carry on a simulation exactly where
+ * it left off.  A file is laid out as:
+ *
+ *   CheckpointHeader
+ *   settings     the Config, as Config::ToString() text
+ *   asteroid     the migration graph and what is in transit (see
+ *                Asteroid::SaveCheckpoint())
+ *   engines      num_engines of them, in engine order (see
+ *                EvolEngine::SaveCheckpoint())
+ *
+ * Unlike a snapshot it isn't meant to be read in place, so after the header
+ * it is just a stream of values in the writer's byte order, strings and
+ * arrays prefixed by their length.  Readers check magic, byte_order and
+ * version and refuse anything else; any change to what is written must bump
+ * kCheckpointVersion.
+ */
+constexpr char kCheckpointMagic[8] = {'E', 'V', 'O', 'L', 'C', 'K', 'P', 'T'};
+constexpr uint32_t kCheckpointByteOrder = 0x01020304;
+constexpr uint32_t kCheckpointVersion = 2;
+
+struct CheckpointHeader {
+  enum Flags : uint32_t { LOCKSTEP = 1 };
+
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t version;
+  uint32_t num_engines;
+  uint32_t flags;
+};
+
+static_assert(sizeof(CheckpointHeader) == 24, "CheckpointHeader layout changed");
+
+
+/**
+ * Appends checkpoint values to a BufferedWriter.
+ */
+class CheckpointWriter {
+ public:
+  explicit CheckpointWriter(BufferedWriter & out) : out_(out) {}
+
+  template <typename T>
+  void Put(const T & v) {
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values are written raw");
+    out_.PutRaw(v);
+  }
+
+  template <typename T>
+  void PutArray(Span<const T> values) {
+    Put(uint64_t(values.size()));
+    out_.Put(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+  }
+
+  void PutString(const std::string & s) {
+    Put(uint64_t(s.size()));
+    out_.Put(s.data(), s.size());
+  }
+
+  void PutDna(const Dna & dna) { PutArray(Span<const OpCode>(dna)); }
+
+  /**
+   * A detached lifeform, e.g. one riding the Asteroid.
+   */
+  void PutLifeform(const Lifeform & lf);
+
+ private:
+  BufferedWriter & out_;
+};
+
+
+/**
+ * Reads back what a CheckpointWriter wrote, from a file read whole into
+ * memory.  Every Get fails (returning false, after complaining on stderr)
+ * once the data runs out or doesn't make sense, and so do all the ones after
+ * it, so a restore can check Ok() once at the end rather than after every
+ * value.
+ */
+class CheckpointReader {
+ public:
+  CheckpointReader() : pos_(0), ok_(false) {}
+
+  /**
+   * Read the given file and check its header.  Returns false (after
+   * complaining on stderr) if it can't be read or isn't a checkpoint.
+   */
+  bool Open(const std::string & filename);
+
+  const CheckpointHeader & Header() const { return header_; }
+
+  template <typename T>
+  bool Get(T *v) {
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values are read raw");
+    if (!Need(sizeof(T))) {
+      return false;
+    }
+    memcpy(v, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  /**
+   * Read an array of at most max_size values into out.
+   */
+  template <typename V>
+  bool GetArray(V *out, uint64_t max_size) {
+    typedef typename V::value_type T;
+    uint64_t size;
+    if (!Get(&size)) {
+      return false;
+    }
+    if (size > max_size) {
+      return Fail("array too long");
+    }
+    if (!Need(size * sizeof(T))) {
+      return false;
+    }
+    out->resize(size);
+    memcpy(out->data(), data_.data() + pos_, size * sizeof(T));
+    pos_ += size * sizeof(T);
+    return true;
+  }
+
+  bool GetString(std::string *s);
+  bool GetDna(Dna *dna);
+  bool GetLifeform(Lifeform *lf);
+
+  /**
+   * Mark the checkpoint bad with the given reason.  Returns false, for
+   * convenience.
+   */
+  bool Fail(const char *error);
+
+  /**
+   * True if every read so far succeeded.
+   */
+  bool Ok() const { return ok_; }
+
+  /**
+   * Bytes not yet read; a bound on how many more values there can be.
+   */
+  size_t Remaining() const { return data_.size() - pos_; }
+
+  /**
+   * True if every read so far succeeded and there is nothing left over.
+   */
+  bool Done();
+
+ private:
+  bool Need(uint64_t bytes);
+
+  std::string filename_;
+  std::vector<char> data_;
+  size_t pos_;
+  bool ok_;
+  CheckpointHeader header_;
+};
+
+
+/**
+ * Write a checkpoint of the given engines and the asteroid between them,
+ * running with the given settings, to filename (via a temporary file, like
+ * WriteLifeformsJson()).  Every engine must be paused or stopped (see
+ * PausePoint).  The asteroid's edges are emptied and refilled in passing.
+ * Returns false (after complaining on stderr) on failure.
+ */
+bool WriteCheckpoint(const std::string & filename, const Config & config,
+                     std::vector<EvolEngine> & engines, Asteroid & asteroid);
+
+
+}  // namespace evol
+#endif  // EVOL_CHECKPOINT_H_
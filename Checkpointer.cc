@@ -0,0 +1,35 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "Checkpointer.h"
+
+#include "Checkpoint.h"
+
+
+namespace evol {
+
+
+/**
+ * Entry point and main loop for the Checkpointer thread.
+ */
+void Checkpointer::CheckpointLoop() {
+  while (!DidGetExitAfterDelay()) {
+    PauseAndCheckpoint();
+    pause_->Resume();
+  }
+}
+
+
+bool Checkpointer::PauseAndCheckpoint() {
+  pause_->Pause();
+  return WriteCheckpoint(config_.checkpoint_filename, config_, *engines_, *asteroid_);
+}
+
+
+}  // namespace evol
@@ -0,0 +1,110 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_CHECKPOINTER_H_
+#define EVOL_CHECKPOINTER_H_
+
+#include <ctime>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Asteroid.h"
+#include "Config.h"
+#include "EvolEngine.h"
+#include "PausePoint.h"
+
+namespace evol {
+
+
+/**
+ * Writes a checkpoint of the whole simulation every so often, on its own
+ * thread.  The engines are paused on a common turn (they must have been given
+ * the same PausePoint) for as long as it takes to write.
+ */
+class Checkpointer {
+ public:
+  Checkpointer() = delete;
+
+  /**
+   * Checkpoint the given engines and asteroid to the config's
+   * checkpoint_filename every checkpoint_interval_seconds.
+   */
+  Checkpointer(std::vector<EvolEngine> * engines, Asteroid * asteroid, PausePoint * pause,
+               const Config & config)
+      : engines_(engines), asteroid_(asteroid), pause_(pause), config_(config),
+        interval_secs_(config.checkpoint_interval_seconds), do_exit_(false) {}
+
+  /**
+   * Start the Checkpointer thread.  Returns after launching it.
+   */
+  void Start() {
+    std::lock_guard<std::mutex> lg(do_exit_mutex_);
+    do_exit_ = false;
+    thread_ = std::thread(&Checkpointer::CheckpointLoop, this);
+  }
+
+  /**
+   * Tell Checkpointer thread to exit; it doesn't write a last checkpoint.
+   */
+  void DoExit() {
+    {
+      std::lock_guard<std::mutex> lg(do_exit_mutex_);
+      do_exit_ = true;
+    }
+    do_exit_cv_.notify_all();
+  }
+
+  void JoinThread() {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  /**
+   * Pause the engines and write a checkpoint.  The engines are left paused,
+   * so they can be told to exit first if this is the last one; call
+   * PausePoint::Resume() to let them go.  Returns false if the checkpoint
+   * couldn't be written.
+   */
+  bool PauseAndCheckpoint();
+
+  void CheckpointLoop();
+
+ private:
+  /**
+   * Sleeps interval_secs_ waiting for do_exit_ to be set.  Returns do_exit_
+   * status.
+   */
+  bool DidGetExitAfterDelay() {
+    std::unique_lock<std::mutex> lk(do_exit_mutex_);
+    return do_exit_cv_.wait_for(lk, std::chrono::seconds(interval_secs_),
+                                [this](){ return do_exit_; });
+  }
+
+  std::vector<EvolEngine> * engines_;
+  Asteroid * asteroid_;
+  PausePoint * pause_;
+  Config config_;
+
+  // Misc runtime state
+  time_t interval_secs_;
+  bool do_exit_;
+  std::mutex do_exit_mutex_;
+  std::condition_variable do_exit_cv_;
+  std::thread thread_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_CHECKPOINTER_H_
@@ -0,0 +1,300 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "Config.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace evol {
+
+
+namespace {
+
+template <typename T>
+struct Field {
+  const char *name;
+  T Config::*member;
+};
+
+const Field<int> kIntFields[] = {
+  {"num_engines", &Config::num_engines},
+  {"width", &Config::width},
+  {"height", &Config::height},
+  {"starting_lifeforms", &Config::starting_lifeforms},
+  {"worker_threads", &Config::worker_threads},
+  {"migration_degree", &Config::migration_degree},
+  {"migration_batch", &Config::migration_batch},
+  {"asteroid_size", &Config::asteroid_size},
+  {"json_dump_interval_seconds", &Config::json_dump_interval_seconds},
+  {"checkpoint_interval_seconds", &Config::checkpoint_interval_seconds},
+  {"max_mutation_length", &Config::max_mutation_length},
+  {"mutation_die_roll", &Config::mutation_die_roll},
+  {"one_mutation", &Config::one_mutation},
+  {"two_mutations", &Config::two_mutations},
+};
+
+const Field<uint64_t> kUint64Fields[] = {
+  {"lifeform_asteroid_launch_interval", &Config::lifeform_asteroid_launch_interval},
+  {"lifeform_asteroid_land_interval", &Config::lifeform_asteroid_land_interval},
+};
+
+const Field<bool> kBoolFields[] = {
+  {"asteroid_evict_on_full", &Config::asteroid_evict_on_full},
+};
+
+const Field<float> kFloatFields[] = {
+  {"cost_of_living", &Config::cost_of_living},
+  {"cost_of_opcode", &Config::cost_of_opcode},
+  {"meiosis_level", &Config::meiosis_level},
+  {"meiosis_cost", &Config::meiosis_cost},
+  {"random_move_cost", &Config::random_move_cost},
+};
+
+const Field<std::string> kStringFields[] = {
+  {"migration_topology", &Config::migration_topology},
+  {"json_dump_filename", &Config::json_dump_filename},
+  {"dump_format", &Config::dump_format},
+  {"snapshot_dump_filename", &Config::snapshot_dump_filename},
+  {"checkpoint_filename", &Config::checkpoint_filename},
+};
+
+// Integers are decimal only, so e.g. width = 010 is ten rather than octal
+bool Parse(const std::string & text, int *out) {
+  char *end;
+  errno = 0;
+  long v = strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || errno != 0 || v < INT32_MIN || v > INT32_MAX)
+    return false;
+  *out = v;
+  return true;
+}
+
+bool Parse(const std::string & text, uint64_t *out) {
+  char *end;
+  errno = 0;
+  unsigned long long v = strtoull(text.c_str(), &end, 10);
+  if (text.empty() || text[0] == '-' || *end != '\0' || errno != 0)
+    return false;
+  *out = v;
+  return true;
+}
+
+bool Parse(const std::string & text, bool *out) {
+  if (text == "1" || text == "true") {
+    *out = true;
+  } else if (text == "0" || text == "false") {
+    *out = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool Parse(const std::string & text, float *out) {
+  char *end;
+  errno = 0;
+  float v = strtof(text.c_str(), &end);
+  if (text.empty() || *end != '\0' || errno != 0)
+    return false;
+  *out = v;
+  return true;
+}
+
+bool Parse(const std::string & text, std::string *out) {
+  *out = text;
+  return true;
+}
+
+/**
+ * Look key up in the given field table.  Returns 1 if it was set, 0 if the
+ * table has no such key, -1 if the value didn't parse.
+ */
+template <typename T, size_t N>
+int SetField(Config *config, const Field<T> (&fields)[N], const std::string & key,
+             const std::string & value) {
+  for (auto & f : fields) {
+    if (key == f.name) {
+      return Parse(value, &(config->*f.member)) ? 1 : -1;
+    }
+  }
+  return 0;
+}
+
+std::string Trim(const std::string & s) {
+  const char *ws = " \t\r\n";
+  size_t begin = s.find_first_not_of(ws);
+  if (begin == std::string::npos)
+    return std::string();
+  return s.substr(begin, s.find_last_not_of(ws) - begin + 1);
+}
+
+}  // namespace anon
+
+
+bool Config::Set(const std::string & key, const std::string & value) {
+  int found = SetField(this, kIntFields, key, value);
+  if (found == 0)
+    found = SetField(this, kUint64Fields, key, value);
+  if (found == 0)
+    found = SetField(this, kBoolFields, key, value);
+  if (found == 0)
+    found = SetField(this, kFloatFields, key, value);
+  if (found == 0)
+    found = SetField(this, kStringFields, key, value);
+
+  if (found == 0) {
+    fprintf(stderr, "Unknown setting '%s'\n", key.c_str());
+    return false;
+  }
+  if (found < 0) {
+    fprintf(stderr, "Bad value '%s' for setting '%s'\n", value.c_str(), key.c_str());
+    return false;
+  }
+  return true;
+}
+
+
+bool Config::Set(const std::string & assignment) {
+  size_t eq = assignment.find('=');
+  if (eq == std::string::npos) {
+    fprintf(stderr, "Expected key=value, got '%s'\n", assignment.c_str());
+    return false;
+  }
+  return Set(Trim(assignment.substr(0, eq)), Trim(assignment.substr(eq + 1)));
+}
+
+
+bool Config::Load(const char *filename) {
+  std::unique_ptr<FILE, int (*)(FILE *)> file(fopen(filename, "r"), fclose);
+  if (!file) {
+    fprintf(stderr, "Can't open config file %s: %s\n", filename, strerror(errno));
+    return false;
+  }
+
+  std::string text;
+  char buf[1024];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), file.get())) > 0) {
+    text.append(buf, n);
+  }
+  return LoadString(text, filename);
+}
+
+
+bool Config::LoadString(const std::string & text, const char *source) {
+  size_t begin = 0;
+  for (int line = 1; begin < text.size(); ++line) {
+    size_t end = text.find('\n', begin);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    std::string setting = text.substr(begin, end - begin);
+    begin = end + 1;
+
+    size_t comment = setting.find('#');
+    if (comment != std::string::npos) {
+      setting.erase(comment);
+    }
+    setting = Trim(setting);
+    if (setting.empty()) {
+      continue;
+    }
+    if (!Set(setting)) {
+      fprintf(stderr, "  at %s:%d\n", source, line);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+bool Config::Validate() const {
+  const char *error = nullptr;
+
+  if (num_engines < 0)
+    error = "num_engines must be >= 0";
+  else if (width < 1 || height < 1)
+    error = "width and height must be >= 1";
+  else if (starting_lifeforms < 0)
+    error = "starting_lifeforms must be >= 0";
+  else if (worker_threads < 0)
+    error = "worker_threads must be >= 0";
+  else if (migration_topology != "all" && migration_topology != "ring" &&
+           migration_topology != "torus" && migration_topology != "random")
+    error = "migration_topology must be all, ring, torus or random";
+  else if (migration_degree < 1)
+    error = "migration_degree must be >= 1";
+  else if (migration_batch < 1)
+    error = "migration_batch must be >= 1";
+  else if (asteroid_size < 1)
+    error = "asteroid_size must be >= 1";
+  else if (json_dump_interval_seconds < 1)
+    error = "json_dump_interval_seconds must be >= 1";
+  else if (checkpoint_interval_seconds < 1)
+    error = "checkpoint_interval_seconds must be >= 1";
+  else if (json_dump_filename.empty() || snapshot_dump_filename.empty())
+    error = "dump filenames must not be empty";
+  else if (dump_format != "json" && dump_format != "binary" && dump_format != "both" &&
+           dump_format != "genomes")
+    error = "dump_format must be json, binary, both or genomes";
+  else if (max_mutation_length < 1)
+    error = "max_mutation_length must be >= 1";
+  else if (mutation_die_roll < 0)
+    error = "mutation_die_roll must be >= 0";
+  else if (two_mutations < one_mutation)
+    error = "two_mutations must be >= one_mutation";
+  else if (one_mutation > mutation_die_roll || two_mutations > mutation_die_roll)
+    error = "one_mutation and two_mutations must be <= mutation_die_roll";
+
+  if (error) {
+    fprintf(stderr, "Bad config: %s\n", error);
+    return false;
+  }
+  return true;
+}
+
+
+std::string Config::ToString() const {
+  std::string text;
+  char buf[1024];
+  for (auto & f : kIntFields) {
+    snprintf(buf, sizeof(buf), "%s = %d\n", f.name, this->*f.member);
+    text += buf;
+  }
+  for (auto & f : kUint64Fields) {
+    snprintf(buf, sizeof(buf), "%s = %" PRIu64 "\n", f.name, this->*f.member);
+    text += buf;
+  }
+  for (auto & f : kBoolFields) {
+    snprintf(buf, sizeof(buf), "%s = %s\n", f.name, this->*f.member ? "true" : "false");
+    text += buf;
+  }
+  for (auto & f : kFloatFields) {
+    snprintf(buf, sizeof(buf), "%s = %.9g\n", f.name, this->*f.member);
+    text += buf;
+  }
+  for (auto & f : kStringFields) {
+    text += std::string(f.name) + " = " + this->*f.member + "\n";
+  }
+  return text;
+}
+
+
+void Config::Print(FILE *out) const {
+  fputs(ToString().c_str(), out);
+}
+
+
+}  // namespace evol
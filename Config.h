@@ -0,0 +1,112 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_CONFIG_H_
+#define EVOL_CONFIG_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "Params.h"
+
+namespace evol {
+
+
+/**
+ * Runtime settings for a simulation.  Every setting defaults to its Params.h
+ * value and can be overridden from a config file of `key = value` lines or
+ * from the command line, so one binary can run many configurations.
+ *
+ * Setting names are the Params names in lower case without the leading k,
+ * e.g. cost_of_living for Params::kCostOfLiving.
+ */
+struct Config {
+  // Engine and arena configs
+  int num_engines = Params::kNumEngines;
+  int width = Params::kWidth;
+  int height = Params::kHeight;
+  int starting_lifeforms = Params::kStartingLifeforms;
+  int worker_threads = Params::kWorkerThreads;
+
+  // Asteroid settings
+  std::string migration_topology = Params::kMigrationTopology;
+  int migration_degree = Params::kMigrationDegree;
+  int migration_batch = Params::kMigrationBatch;
+  int asteroid_size = Params::kAsteroidSize;
+  bool asteroid_evict_on_full = Params::kAsteroidEvictOnFull;
+  uint64_t lifeform_asteroid_launch_interval = Params::kLifeformAsteroidLaunchInterval;
+  uint64_t lifeform_asteroid_land_interval = Params::kLifeformAsteroidLandInterval;
+
+  // Lifeform energy costs
+  float cost_of_living = Params::kCostOfLiving;
+  float cost_of_opcode = Params::kCostOfOpcode;
+  float meiosis_level = Params::kMeiosisLevel;
+  float meiosis_cost = Params::kMeiosisCost;
+  float random_move_cost = Params::kRandomMoveCost;
+
+  // Dump settings
+  int json_dump_interval_seconds = Params::kJsonDumpIntervalSeconds;
+  std::string json_dump_filename = Params::kJsonDumpFilename;
+  std::string dump_format = Params::kDumpFormat;
+  std::string snapshot_dump_filename = Params::kSnapshotDumpFilename;
+
+  // Checkpoint settings
+  int checkpoint_interval_seconds = Params::kCheckpointIntervalSeconds;
+  std::string checkpoint_filename = Params::kCheckpointFilename;
+
+  // Lifeform Dna code parameters
+  int32_t max_mutation_length = Params::kMaxMutationLength;
+  int32_t mutation_die_roll = Params::kMutationDieRoll;
+  int32_t one_mutation = Params::kOneMutation;
+  int32_t two_mutations = Params::kTwoMutations;
+
+  /**
+   * Set one setting from its text value.  Returns false (after complaining
+   * on stderr) if there is no such setting or the value doesn't parse.
+   */
+  bool Set(const std::string & key, const std::string & value);
+
+  /**
+   * Set one setting from a `key=value` string, as given on the command line.
+   */
+  bool Set(const std::string & assignment);
+
+  /**
+   * Apply every `key = value` line of the given file.  Blank lines and
+   * anything after a # are ignored.  Returns false on the first bad line.
+   */
+  bool Load(const char *filename);
+
+  /**
+   * Apply every line of the given text, as Load() does a file's.  Errors
+   * are reported against source.
+   */
+  bool LoadString(const std::string & text, const char *source);
+
+  /**
+   * Returns false (after complaining on stderr) if settings are out of range
+   * or contradict each other.
+   */
+  bool Validate() const;
+
+  /**
+   * Return every setting in Load() format, one per line.
+   */
+  std::string ToString() const;
+
+  /**
+   * Write ToString() to the given file.
+   */
+  void Print(FILE *out) const;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_CONFIG_H_
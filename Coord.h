@@ -50,10 +50,10 @@ class Coord {
     return x == other.x && y == other.y;
   }
 
-  Coord North() { return Coord(x, y - 1); }
-  Coord South() { return Coord(x, y + 1); }
-  Coord East() { return Coord(x + 1, y); }
-  Coord West() { return Coord(x - 1, y); }
+  Coord North() const { return Coord(x, y - 1); }
+  Coord South() const { return Coord(x, y + 1); }
+  Coord East() const { return Coord(x + 1, y); }
+  Coord West() const { return Coord(x - 1, y); }
 
   /**
    * Wraps the coordinate inside the global boundary box.
@@ -66,15 +66,17 @@ class Coord {
    * Wraps the coordinate inside the given boundary box.
    */
   void Normalize(Unit xMax, Unit yMax) {
-    if (x < 0) {
-      x = x % xMax + xMax;
-    } else if (x >= Coord::max_x_) {
+    if (x < 0 || x >= xMax) {
       x %= xMax;
+      if (x < 0) {
+        x += xMax;
+      }
     }
-    if (y < 0) {
-      y = y % yMax + yMax;
-    } else if (y >= Coord::max_x_) {
+    if (y < 0 || y >= yMax) {
       y %= yMax;
+      if (y < 0) {
+        y += yMax;
+      }
     }
   }
 
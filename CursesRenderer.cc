@@ -15,6 +15,7 @@
 #include <sys/time.h>
 
 #include <cstdint>
+#include <forward_list>
 #include <list>
 
 #include "Arena.h"
@@ -41,7 +42,7 @@ void CursesRenderer::Cleanup() {
 }
 
 
-void CursesRenderer::Run() {
+void CursesRenderer::Run(const volatile sig_atomic_t * exit_signal) {
   if (!did_init_) {
     abort();
   }
@@ -49,7 +50,7 @@ void CursesRenderer::Run() {
   int us_per_frame = 1e6 / target_fps_;
   struct timeval start_time, end_time;
 
-  for (;;) {
+  while (!*exit_signal) {
     int key = getch();
 
     if (key == 27 /* ESC */ || key == 'q' || key == 'Q') {
@@ -115,11 +116,12 @@ void CursesRenderer::RenderFrame(const Timer * poll_timer) {
       total_num_dead += num_dead;
 
       // Get average DNA length
-      for (auto & lf : arena.Lifeforms()) {
-        uint64_t dl = lf->GetDnaSize();
+      for (uint64_t dl : arena.Lifeforms().DnaSizes()) {
         average_dna_len += dl;
         total_dna_len += dl;
-        highest_gen = std::max(highest_gen, lf->Gen());
+      }
+      for (auto gen : arena.Lifeforms().Gens()) {
+        highest_gen = std::max(highest_gen, gen);
       }
       average_dna_len /= num_alive;
 
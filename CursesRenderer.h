@@ -8,6 +8,7 @@
  */
 
 #pragma once
+#include <csignal>
 #include <cstdint>
 #include <vector>
 
@@ -36,7 +37,10 @@ class CursesRenderer {
   CursesRenderer & operator=(const CursesRenderer &) = delete;
 
   void Init();
-  void Run();
+  /**
+   * Render until the user quits or *exit_signal becomes nonzero.
+   */
+  void Run(const volatile sig_atomic_t * exit_signal);
   void Cleanup();
 
  private:
@@ -0,0 +1,338 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "DecisionTable.h"
+
+#include <cstdint>
+#include <cstdlib>  // abort()
+
+namespace evol {
+
+
+namespace {
+
+// Flag / registers for Dna execution
+typedef uint8_t Flag;
+
+// This bit is set for various CMP opcodes
+constexpr uint8_t kCmpFlag = 0x01;
+
+
+/**
+ * Set/clear the given bit in the given flag type based on the boolean
+ * value of the predicate.
+ */
+inline void set_flag_if(Flag & flags, const Flag & bit, bool pred = true) {
+  if (pred)
+    flags |= bit;
+  else
+    flags &= ~bit;
+}
+
+/**
+ * Gets the flag value.
+ */
+inline bool get_flag(const Flag & flags, const Flag & bit) {
+  return flags & bit;
+}
+
+
+// A set of sensor states, one bit per state
+typedef uint64_t StateSet;
+static_assert(kNumSensorStates == 64, "a StateSet must hold every sensor state");
+
+constexpr StateSet kAllStates = ~StateSet(0);
+
+// Furthest a jump lands (JMP5 skips five opcodes, landing six past itself),
+// and the size of ring needed to track arrivals that far ahead (a power of
+// two, for cheap modulo)
+constexpr size_t kMaxJump = 6;
+constexpr size_t kRingSize = 8;
+static_assert(kRingSize > kMaxJump, "ring must reach the furthest jump target");
+
+
+/**
+ * Returns the states in which the given sensor bit is set.
+ */
+inline StateSet states_sensing(SensorBits sensor) {
+  switch (sensor) {
+    case 1 << 0: return 0xaaaaaaaaaaaaaaaa;
+    case 1 << 1: return 0xcccccccccccccccc;
+    case 1 << 2: return 0xf0f0f0f0f0f0f0f0;
+    case 1 << 3: return 0xff00ff00ff00ff00;
+    case 1 << 4: return 0xffff0000ffff0000;
+    case 1 << 5: return 0xffffffff00000000;
+    default: abort();
+  }
+}
+
+
+/**
+ * Add the given states to those arriving at ring slot target by a jump.
+ */
+inline void Jump(StateSet * jumped_off, StateSet * jumped_on, uint8_t * jumped, size_t target,
+                 StateSet off, StateSet on) {
+  if (*jumped & (1 << target)) {
+    jumped_off[target] |= off;
+    jumped_on[target] |= on;
+  } else {
+    jumped_off[target] = off;
+    jumped_on[target] = on;
+    *jumped |= 1 << target;
+  }
+}
+
+
+/**
+ * Returns the number of opcodes skipped by the given JMPn or CJMPn.
+ */
+inline size_t jump_length(OpCode opcode) {
+  if (opcode >= OpCode::CJMP1)
+    return static_cast<size_t>(opcode) - static_cast<size_t>(OpCode::CJMP1) + 1;
+  return static_cast<size_t>(opcode) - static_cast<size_t>(OpCode::JMP1) + 1;
+}
+
+
+/**
+ * Returns the action taken by the given APOPTOSIS or FINAL_* opcode.
+ */
+inline ActionType final_action(OpCode opcode) {
+  switch (opcode) {
+    case OpCode::APOPTOSIS:
+      return ActionType::APOPTOSIS;
+    case OpCode::FINAL_MOVE_NORTH:
+      return ActionType::MOVE_NORTH;
+    case OpCode::FINAL_MOVE_EAST:
+      return ActionType::MOVE_EAST;
+    case OpCode::FINAL_MOVE_SOUTH:
+      return ActionType::MOVE_SOUTH;
+    case OpCode::FINAL_MOVE_WEST:
+      return ActionType::MOVE_WEST;
+    default:
+      return ActionType::MOVE_RANDOM;
+  }
+}
+
+}  // namespace anon
+
+
+DecisionTable::DecisionTable(const Dna & dna) : sensors_(0) {
+  for (auto opcode : dna) {
+    sensors_ |= OpcodeSensor(opcode);
+  }
+
+  if (dna.empty()) {
+    // A lifeform with no Dna dies
+    decisions_.fill(ActionType::APOPTOSIS);
+    return;
+  }
+  // States which run off the end of the Dna do nothing
+  decisions_.fill(ActionType::NOTHING);
+
+  // Run sensor states through the Dna all at once, in one pass.  Bit s of a
+  // StateSet stands for state s, and states are split by whether their cmp
+  // flag is clear (off) or set (on).  States falling through to the next
+  // opcode are carried in off/on; jumps only go forward, by at most kMaxJump
+  // opcodes, so a small ring of arrivals ahead holds the rest, and a bit per
+  // slot says which slots have any.
+  //
+  // Only states built from tested sensors need running; every other state
+  // has the same outcome as its masked-down counterpart.
+  StateSet relevant = kAllStates;
+  for (SensorBits sensor = 1; sensor < kNumSensorStates; sensor <<= 1) {
+    if (!(sensors_ & sensor))
+      relevant &= ~states_sensing(sensor);
+  }
+  StateSet jumped_off[kRingSize];
+  StateSet jumped_on[kRingSize];
+  uint8_t jumped = 0;
+  StateSet off = relevant;
+  StateSet on = 0;
+  StateSet running = relevant;
+
+  const size_t size = dna.size();
+  for (size_t pc = 0; pc < size && running; pc++) {
+    const size_t slot = pc % kRingSize;
+    if (jumped & (1 << slot)) {
+      off |= jumped_off[slot];
+      on |= jumped_on[slot];
+      jumped &= ~(1 << slot);
+    }
+    if (!(off | on))
+      continue;  // Jumped over by every state
+
+    const OpCode opcode = dna[pc];
+    switch (opcode) {
+      case OpCode::NOP:
+        continue;
+
+      case OpCode::IS_NORTH_OCCUPIED:
+      case OpCode::IS_SOUTH_OCCUPIED:
+      case OpCode::IS_EAST_OCCUPIED:
+      case OpCode::IS_WEST_OCCUPIED:
+      case OpCode::IS_CROWDED:
+      case OpCode::IS_NEIGHBOR: {
+        const StateSet here = off | on;
+        const StateSet sensed = states_sensing(OpcodeSensor(opcode));
+        off = here & ~sensed;
+        on = here & sensed;
+        continue;
+      }
+
+      case OpCode::JMP1:
+      case OpCode::JMP2:
+      case OpCode::JMP3:
+      case OpCode::JMP4:
+      case OpCode::JMP5: {
+        Jump(jumped_off, jumped_on, &jumped, (pc + 1 + jump_length(opcode)) % kRingSize,
+             off, on);
+        off = 0;
+        on = 0;
+        continue;
+      }
+      case OpCode::CJMP1:
+      case OpCode::CJMP2:
+      case OpCode::CJMP3:
+      case OpCode::CJMP4:
+      case OpCode::CJMP5: {
+        Jump(jumped_off, jumped_on, &jumped, (pc + 1 + jump_length(opcode)) % kRingSize,
+             0, on);
+        on = 0;
+        continue;
+      }
+
+      case OpCode::APOPTOSIS:
+      case OpCode::FINAL_MOVE_NORTH:
+      case OpCode::FINAL_MOVE_EAST:
+      case OpCode::FINAL_MOVE_SOUTH:
+      case OpCode::FINAL_MOVE_WEST:
+      case OpCode::FINAL_MOVE_RANDOM: {
+        const ActionType action = final_action(opcode);
+        for (StateSet states = off | on; states; states &= states - 1) {
+          decisions_[__builtin_ctzll(states)] = action;
+        }
+        running &= ~(off | on);
+        off = 0;
+        on = 0;
+        continue;
+      }
+      default:
+        // We should handle all cases in this for loop; not doing so is fatal
+        abort();
+    }
+  }
+
+  // Masked-down states are always smaller indices, so already filled in
+  for (unsigned state = 0; state < kNumSensorStates; ++state) {
+    decisions_[state] = decisions_[state & sensors_];
+  }
+}
+
+
+ActionType DecisionTable::Evaluate(const Dna & dna, SensorBits state) {
+  if (dna.empty()) {
+    // A lifeform with no Dna dies
+    return ActionType::APOPTOSIS;
+  }
+
+  uint8_t flags = 0;
+  const size_t size = dna.size();
+
+  for (size_t pc = 0; pc < size; pc++) {
+    switch (dna[pc]) {
+      // Basic NOP case, do nothing
+      case OpCode::NOP:
+        continue;
+      // Suicide
+      case OpCode::APOPTOSIS:
+        return ActionType::APOPTOSIS;
+
+      // Set cmp flags based on whether targeted square is occupied
+      case OpCode::IS_NORTH_OCCUPIED:
+        set_flag_if(flags, kCmpFlag, state & kSensorNorth);
+        continue;
+      case OpCode::IS_SOUTH_OCCUPIED:
+        set_flag_if(flags, kCmpFlag, state & kSensorSouth);
+        continue;
+      case OpCode::IS_EAST_OCCUPIED:
+        set_flag_if(flags, kCmpFlag, state & kSensorEast);
+        continue;
+      case OpCode::IS_WEST_OCCUPIED:
+        set_flag_if(flags, kCmpFlag, state & kSensorWest);
+        continue;
+
+      // Set cmp flag if local tile has other lifeforms
+      case OpCode::IS_CROWDED:
+        set_flag_if(flags, kCmpFlag, state & kSensorCrowded);
+        continue;
+      // Set cmp flag if adjacent tiles have other lifeforms (local is ignored)
+      case OpCode::IS_NEIGHBOR:
+        set_flag_if(flags, kCmpFlag, state & kSensorNeighbor);
+        continue;
+
+      // Final moves, return action
+      case OpCode::FINAL_MOVE_NORTH:
+        return ActionType::MOVE_NORTH;
+      case OpCode::FINAL_MOVE_EAST:
+        return ActionType::MOVE_EAST;
+      case OpCode::FINAL_MOVE_SOUTH:
+        return ActionType::MOVE_SOUTH;
+      case OpCode::FINAL_MOVE_WEST:
+        return ActionType::MOVE_WEST;
+      case OpCode::FINAL_MOVE_RANDOM:
+        return ActionType::MOVE_RANDOM;
+
+      // JMP & friends
+      case OpCode::JMP1:
+        pc += 1;
+        continue;
+      case OpCode::JMP2:
+        pc += 2;
+        continue;
+      case OpCode::JMP3:
+        pc += 3;
+        continue;
+      case OpCode::JMP4:
+        pc += 4;
+        continue;
+      case OpCode::JMP5:
+        pc += 5;
+        continue;
+      case OpCode::CJMP1:
+        if (get_flag(flags, kCmpFlag))
+          pc += 1;
+        continue;
+      case OpCode::CJMP2:
+        if (get_flag(flags, kCmpFlag))
+          pc += 2;
+        continue;
+      case OpCode::CJMP3:
+        if (get_flag(flags, kCmpFlag))
+          pc += 3;
+        continue;
+      case OpCode::CJMP4:
+        if (get_flag(flags, kCmpFlag))
+          pc += 4;
+        continue;
+      case OpCode::CJMP5:
+        if (get_flag(flags, kCmpFlag))
+          pc += 5;
+        continue;
+      default:
+        // We should handle all cases in this for loop; not doing so is fatal
+        abort();
+    }
+  }
+
+  // Dna execution ended without a FINAL_* action
+  return ActionType::NOTHING;
+}
+
+
+}  // namespace evol
@@ -0,0 +1,111 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_DECISION_TABLE_H_
+#define EVOL_DECISION_TABLE_H_
+
+#include <array>
+#include <cstdint>
+
+#include "Dna.h"
+#include "Types.h"
+
+namespace evol {
+
+
+// Everything a lifeform's Dna can ask about its surroundings fits in six bits;
+// each IS_* opcode tests exactly one of them.
+typedef uint8_t SensorBits;
+
+constexpr SensorBits kSensorNorth = 1 << 0;     // IS_NORTH_OCCUPIED
+constexpr SensorBits kSensorSouth = 1 << 1;     // IS_SOUTH_OCCUPIED
+constexpr SensorBits kSensorEast = 1 << 2;      // IS_EAST_OCCUPIED
+constexpr SensorBits kSensorWest = 1 << 3;      // IS_WEST_OCCUPIED
+constexpr SensorBits kSensorCrowded = 1 << 4;   // IS_CROWDED
+constexpr SensorBits kSensorNeighbor = 1 << 5;  // IS_NEIGHBOR
+
+// Number of sensors, and of distinct sensor states (2^6)
+constexpr unsigned kNumSensors = 6;
+constexpr unsigned kNumSensorStates = 1 << kNumSensors;
+
+/**
+ * Returns the sensor tested by the given opcode, or 0 if it tests none.
+ */
+inline SensorBits OpcodeSensor(OpCode opcode) {
+  switch (opcode) {
+    case OpCode::IS_NORTH_OCCUPIED:
+      return kSensorNorth;
+    case OpCode::IS_SOUTH_OCCUPIED:
+      return kSensorSouth;
+    case OpCode::IS_EAST_OCCUPIED:
+      return kSensorEast;
+    case OpCode::IS_WEST_OCCUPIED:
+      return kSensorWest;
+    case OpCode::IS_CROWDED:
+      return kSensorCrowded;
+    case OpCode::IS_NEIGHBOR:
+      return kSensorNeighbor;
+    default:
+      return 0;
+  }
+}
+
+
+/**
+ * A DecisionTable is a lifeform's Dna compiled down to the action it selects
+ * for every possible combination of sensor inputs.  Since the sensors are the
+ * only inputs to Dna execution, a turn becomes "gather sensor bits, index
+ * table" no matter how long (or how full of NOPs and jumps) the Dna is.
+ *
+ * FINAL_MOVE_RANDOM compiles to ActionType::MOVE_RANDOM; picking the actual
+ * direction is left to the caller.
+ */
+class DecisionTable {
+ public:
+  /**
+   * An empty table; every state results in ActionType::NOTHING.
+   */
+  DecisionTable() : sensors_(0) {
+    decisions_.fill(ActionType::NOTHING);
+  }
+
+  /**
+   * Compile the given Dna.
+   */
+  explicit DecisionTable(const Dna & dna);
+
+  /**
+   * Return the action selected for the given sensor state.  Bits which the Dna
+   * never tests are ignored.
+   */
+  ActionType Lookup(SensorBits state) const {
+    return decisions_[state & (kNumSensorStates - 1)];
+  }
+
+  /**
+   * Return the set of sensors the Dna may test; the caller need not gather the
+   * others.
+   */
+  SensorBits Sensors() const { return sensors_; }
+
+  /**
+   * Interpret the Dna directly for one sensor state.  This is the reference
+   * implementation; tables are compiled by running all states through the
+   * Dna together, which must agree with it.
+   */
+  static ActionType Evaluate(const Dna & dna, SensorBits state);
+
+ private:
+  std::array<ActionType, kNumSensorStates> decisions_;
+  SensorBits sensors_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_DECISION_TABLE_H_
@@ -0,0 +1,230 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_DNA_H_
+#define EVOL_DNA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+
+#include "Span.h"
+#include "Types.h"
+
+namespace evol {
+
+
+/**
+ * A lifeform's Dna: a sequence of opcodes, with the parts of the
+ * std::vector<OpCode> interface evol uses.  Sequences of up to
+ * kInlineCapacity opcodes, which is most evolved Dna, are stored inside the
+ * object itself, so making, copying and dropping them never touches the
+ * heap.  Longer ones move out to a heap buffer, which grows by doubling.
+ *
+ * Opcodes are stored a byte apiece, so any Dna can be viewed as a
+ * Span<const OpCode> for hashing, comparing or writing out without a copy.
+ */
+class Dna {
+ public:
+  typedef OpCode value_type;
+  typedef OpCode * iterator;
+  typedef const OpCode * const_iterator;
+  typedef size_t size_type;
+
+  // Room inside the object; it's then the size of a std::vector
+  static constexpr size_t kInlineCapacity = 16;
+
+  Dna() : size_(0), capacity_(kInlineCapacity) {}
+
+  /**
+   * Dna of n NOPs.
+   */
+  explicit Dna(size_t n) : Dna() { resize(n); }
+
+  Dna(std::initializer_list<OpCode> opcodes) : Dna() { assign(opcodes.begin(), opcodes.end()); }
+  Dna(const OpCode * first, const OpCode * last) : Dna() { assign(first, last); }
+
+  Dna(const Dna & o) : Dna() { assign(o.begin(), o.end()); }
+  Dna(Dna && o) noexcept : storage_(o.storage_), size_(o.size_), capacity_(o.capacity_) {
+    o.size_ = 0;
+    o.capacity_ = kInlineCapacity;
+  }
+  ~Dna() { Release(); }
+
+  Dna & operator=(const Dna & o) {
+    if (this != &o) {
+      assign(o.begin(), o.end());
+    }
+    return *this;
+  }
+  Dna & operator=(Dna && o) noexcept {
+    if (this != &o) {
+      Release();
+      storage_ = o.storage_;
+      size_ = o.size_;
+      capacity_ = o.capacity_;
+      o.size_ = 0;
+      o.capacity_ = kInlineCapacity;
+    }
+    return *this;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return capacity_; }
+
+  OpCode * data() { return IsInline() ? storage_.inline_ : storage_.heap_; }
+  const OpCode * data() const { return IsInline() ? storage_.inline_ : storage_.heap_; }
+
+  iterator begin() { return data(); }
+  iterator end() { return data() + size_; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size_; }
+
+  OpCode & operator[](size_t i) {
+    assert(i < size_);
+    return data()[i];
+  }
+  const OpCode & operator[](size_t i) const {
+    assert(i < size_);
+    return data()[i];
+  }
+
+  operator Span<const OpCode>() const { return Span<const OpCode>(data(), size_); }
+  operator Span<OpCode>() { return Span<OpCode>(data(), size_); }
+
+  bool operator==(const Dna & o) const {
+    return size_ == o.size_ && memcmp(data(), o.data(), size_) == 0;
+  }
+  bool operator!=(const Dna & o) const { return !(*this == o); }
+
+  /**
+   * Empty the Dna, keeping its buffer.
+   */
+  void clear() { size_ = 0; }
+
+  void reserve(size_t n) {
+    if (n > capacity_) {
+      Grow(n);
+    }
+  }
+
+  /**
+   * Truncate, or pad with NOPs, to n opcodes.
+   */
+  void resize(size_t n) {
+    reserve(n);
+    if (n > size_) {
+      memset(data() + size_, static_cast<int>(OpCode::NOP), n - size_);
+    }
+    size_ = n;
+  }
+
+  void assign(const OpCode * first, const OpCode * last) {
+    const size_t n = last - first;
+    size_ = 0;
+    reserve(n);
+    memmove(data(), first, n);
+    size_ = n;
+  }
+
+  void push_back(OpCode opcode) {
+    reserve(size_ + 1);
+    data()[size_++] = opcode;
+  }
+
+  /**
+   * Insert n copies of opcode before pos.  Returns the first inserted.
+   */
+  iterator insert(const_iterator pos, size_t n, OpCode opcode) {
+    const size_t at = pos - begin();
+    assert(at <= size_);
+    reserve(size_ + n);
+    OpCode * d = data();
+    memmove(d + at + n, d + at, size_ - at);
+    memset(d + at, static_cast<int>(opcode), n);
+    size_ += n;
+    return d + at;
+  }
+
+  /**
+   * Insert a copy of [first, last), which mustn't lie in this Dna, before
+   * pos.  Returns the first inserted.
+   */
+  iterator insert(const_iterator pos, const OpCode * first, const OpCode * last) {
+    const size_t at = pos - begin();
+    const size_t n = last - first;
+    assert(at <= size_);
+    reserve(size_ + n);
+    OpCode * d = data();
+    memmove(d + at + n, d + at, size_ - at);
+    memcpy(d + at, first, n);
+    size_ += n;
+    return d + at;
+  }
+
+  /**
+   * Remove [first, last).  Returns the opcode which followed them.
+   */
+  iterator erase(const_iterator first, const_iterator last) {
+    const size_t at = first - begin();
+    const size_t n = last - first;
+    assert(at + n <= size_);
+    OpCode * d = data();
+    memmove(d + at, d + at + n, size_ - at - n);
+    size_ -= n;
+    return d + at;
+  }
+
+ private:
+  static_assert(sizeof(OpCode) == 1, "Dna stores opcodes as bytes");
+
+  bool IsInline() const { return capacity_ == kInlineCapacity; }
+
+  void Release() {
+    if (!IsInline()) {
+      free(storage_.heap_);
+    }
+  }
+
+  // Move to a heap buffer of at least min_capacity opcodes
+  void Grow(size_t min_capacity) {
+    size_t capacity = 2 * capacity_;
+    while (capacity < min_capacity) {
+      capacity *= 2;
+    }
+    OpCode * heap = static_cast<OpCode *>(malloc(capacity));
+    if (heap == nullptr) {
+      abort();
+    }
+    memcpy(heap, data(), size_);
+    Release();
+    storage_.heap_ = heap;
+    capacity_ = capacity;
+  }
+
+  union Storage {
+    OpCode inline_[kInlineCapacity];
+    OpCode * heap_;
+  } storage_;
+  uint32_t size_;
+  uint32_t capacity_;  // kInlineCapacity while stored inline
+};
+
+// Lets std::vector<Dna> move, rather than deep-copy, on growth
+static_assert(std::is_nothrow_move_constructible<Dna>::value &&
+              std::is_nothrow_move_assignable<Dna>::value, "Dna moves must be noexcept");
+
+
+}  // namespace evol
+#endif  // EVOL_DNA_H_
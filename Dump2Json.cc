@@ -0,0 +1,47 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+// evol-dump2json: convert a binary snapshot dump to the JSON dump format read
+// by reduce_lifeform_opcodes.py.
+
+#include <cstdio>
+#include <vector>
+
+#include "LifeformJson.h"
+#include "LifeformSnapshot.h"
+#include "SnapshotFile.h"
+
+using namespace evol;
+
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <snapshot dump> <JSON output>\n", argv[0]);
+    return 1;
+  }
+
+  SnapshotReader reader;
+  if (!reader.Open(argv[1])) {
+    return 1;
+  }
+
+  Span<const SnapshotRecord> records = reader.Records();
+  std::vector<LifeformSnapshot> snapshots(reader.Sections().size());
+  for (size_t i = 0; i < snapshots.size(); ++i) {
+    const SnapshotSection & section = reader.Sections()[i];
+    for (uint64_t r = section.first_record; r < section.first_record + section.num_records; ++r) {
+      const SnapshotRecord & record = records[r];
+      LifeformSnapshot::Record lf = {record.id, record.gen, record.energy,
+                                     (record.flags & SnapshotRecord::ALIVE) != 0, 0, 0};
+      snapshots[i].Add(lf, reader.GetDna(record));
+    }
+  }
+
+  return WriteLifeformsJson(snapshots, argv[2]) ? 0 : 1;
+}
@@ -9,25 +9,36 @@
 
 #include "Dumper.h"
 
+#include <algorithm>
 #include <cstring>
 #include <chrono>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "Arena.h"
 #include "EvolEngine.h"
+#include "LifeformJson.h"
+#include "SnapshotFile.h"
 
 
 namespace evol {
 
 
-static const char * kDumperFilename = "lifeform-dump.json";
-
-
 /**
  * Entry point and main loop for the Dumper thread.
  */
 void Dumper::DumpLoop() {
+  // Genome tables are built an engine per thread
+  unsigned helpers = 0;
+  if (!genomes_filename_.empty()) {
+    helpers = std::min<unsigned>(engines_->size(), std::thread::hardware_concurrency());
+    helpers = std::max(helpers, 1u) - 1;
+  }
+  ThreadPool workers(helpers);
+  workers_ = &workers;
+
   for (;;) {
     if (DidGetExitAfterDelay()) {
       break;
@@ -37,45 +48,46 @@ void Dumper::DumpLoop() {
 
   // Final data dump before we exit
   DumpAllEngines();
+  workers_ = nullptr;
 }
 
 
 /**
- * Lock all engines and grab their lifeforms.  We leave the engines locked
- * since we're only getting pointers to the lifeforms and they'll still need
- * to be converted to libjson-c objects.
- *
- * TODO: Copy the lifeforms before JSON-ifying them so we can release the
- * engine locks sooner.
+ * Snapshot each engine's lifeforms in turn, then write them all out.  An
+ * engine is only held up while its own lifeforms are copied; the slow part
+ * happens on this thread with no engine locked.  (So each engine's part of
+ * the dump is from a slightly different moment.)
  */
 void Dumper::DumpAllEngines() {
-  std::vector<Lifeform> all_lifeforms;
-
-  // Copy lifeform list from each engine
   for (size_t i = 0; i < engines_->size(); ++i) {
-    engine_locks_[i].lock();
-    auto & arena = engines_->at(i).GetArena();
-    auto arena_lifeforms = arena.Lifeforms();
-    all_lifeforms.insert(all_lifeforms.end(), arena_lifeforms.cbegin(), arena_lifeforms.cend());
+    engines_->at(i).TakeSnapshot(snapshots_[i]);
   }
 
-  // Jsonify lifeforms
-  auto json_lifeform_array = JsonifyLifeforms(all_lifeforms.cbegin(), all_lifeforms.cend());
-
-  // Release engines
-  for (auto & lck : engine_locks_) {
-    lck.unlock();
+  if (!json_filename_.empty()) {
+    WriteLifeformsJson(snapshots_, json_filename_);
   }
+  if (!snapshot_filename_.empty()) {
+    WriteLifeformsSnapshot(snapshots_, snapshot_filename_);
+  }
+  if (!genomes_filename_.empty()) {
+    BuildGenomeTables();
+    WriteGenomesJson(snapshots_, genome_tables_, genomes_, genome_remaps_, genomes_filename_);
+  }
+}
+
 
-  // libjson's functions require non-const filename arg :/
-  constexpr size_t kMaxFilename = 256;
-  char filename[kMaxFilename];
-  strncpy(filename, kDumperFilename, kMaxFilename);
-  json_object_to_file_ext(
-    filename,
-    json_lifeform_array.get(),
-    JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_NOZERO
-  );
+void Dumper::BuildGenomeTables() {
+  auto build = [this](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      genome_tables_[i].Build(snapshots_[i]);
+    }
+  };
+  workers_->ParallelFor(snapshots_.size(), 1, build);
+
+  genomes_.Clear();
+  for (size_t i = 0; i < genome_tables_.size(); ++i) {
+    genomes_.Merge(genome_tables_[i], &genome_remaps_[i]);
+  }
 }
 
 
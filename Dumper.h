@@ -15,11 +15,15 @@
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include "EvolEngine.h"
-#include "LifeformJson.h"
+#include "GenomeTable.h"
+#include "LifeformSnapshot.h"
+#include "Params.h"
+#include "ThreadPool.h"
 
 namespace evol {
 
@@ -28,15 +32,19 @@ class Dumper {
  public:
   Dumper() = delete;
 
-  Dumper(std::vector<EvolEngine> * engines, time_t interval = 30)
-        : engines_(engines), dump_interval_secs_(interval), do_exit_(false) {
-    // Build a lock for each engine
-    engine_locks_.resize(engines_->size());
-    for (unsigned i = 0; i < engines_->size(); ++i) {
-      EvolEngine & e = (*engines_)[i];
-      engine_locks_[i] = std::unique_lock<std::mutex>(e.Mutex(), std::defer_lock);
-    }
-  }
+  /**
+   * Dump every interval seconds, as JSON to json_filename, as a binary
+   * snapshot to snapshot_filename and as genome-deduplicated JSON to
+   * genomes_filename.  Leave a filename empty to skip that format.
+   */
+  Dumper(std::vector<EvolEngine> * engines, time_t interval = 30,
+         const std::string & json_filename = Params::kJsonDumpFilename,
+         const std::string & snapshot_filename = std::string(),
+         const std::string & genomes_filename = std::string())
+        : engines_(engines), snapshots_(engines->size()), genome_tables_(engines->size()),
+          genome_remaps_(engines->size()), dump_interval_secs_(interval),
+          json_filename_(json_filename), snapshot_filename_(snapshot_filename),
+          genomes_filename_(genomes_filename), do_exit_(false) {}
 
   /**
    * Start the Dumper thread.  Returns after launching it.
@@ -89,17 +97,35 @@ class Dumper {
  private:
   void DumpAllEngines();
 
-  // Engine hooks
+  /**
+   * Find the distinct genomes in each snapshot, an engine per thread, then
+   * merge them into genomes_.
+   */
+  void BuildGenomeTables();
+
+  // Engine hooks, and a snapshot of each engine's lifeforms (kept between
+  // dumps so their buffers are reused)
   std::vector<EvolEngine> * engines_;
-  std::vector<std::unique_lock<std::mutex>> engine_locks_;
+  std::vector<LifeformSnapshot> snapshots_;
+
+  // For the genomes dump: each snapshot's genomes, all engines' genomes, and
+  // where each engine's genomes ended up in the latter
+  std::vector<GenomeTable> genome_tables_;
+  GenomeTable genomes_;
+  std::vector<std::vector<uint32_t>> genome_remaps_;
+
+  // Helper threads, while DumpLoop() is running
+  ThreadPool * workers_ = nullptr;
 
   // Misc runtime state
   time_t dump_interval_secs_;
+  std::string json_filename_;
+  std::string snapshot_filename_;
+  std::string genomes_filename_;
   bool do_exit_;
   std::mutex do_exit_mutex_;
   std::condition_variable do_exit_cv_;
   std::thread thread_;
-  std::unique_ptr<char[]> filename_;
 };
 
 
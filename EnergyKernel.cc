@@ -0,0 +1,364 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "EnergyKernel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>  // abort()
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define EVOL_ENERGY_KERNEL_X86 1
+#  include <immintrin.h>
+#endif
+
+namespace evol {
+
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////
+// Scalar
+//
+// These define the exact arithmetic; the SIMD versions below must perform
+// the same operations in the same order.  They also handle the wrapped edge
+// columns for the SIMD versions, which only do the interior of each row.
+//
+// Shares and energy levels keep their fractions, so a square's energy is
+// handed out in full however many lifeforms split it.
+
+/**
+ * Sum the 8 squares surrounding x on the current row of the given row-major
+ * plane.  up, row and down are the offsets of the wrapped rows above, at and
+ * below; left and right are the wrapped columns either side of x.
+ */
+template <typename T>
+inline T sum_adjacent(const T *plane, int up, int row, int down, int left, int x, int right) {
+  return plane[up + left] + plane[up + x] + plane[up + right] +
+         plane[row + left] + plane[row + right] +
+         plane[down + left] + plane[down + x] + plane[down + right];
+}
+
+/**
+ * Share of an empty square's energy for each adjacent lifeform, or 0 if the
+ * square is occupied (or nobody is adjacent).
+ */
+inline void share_at(const float *energy, const uint32_t *occupancy, float *shares,
+                     int width, int up, int row, int down, int x) {
+  const int left = x == 0 ? width - 1 : x - 1;
+  const int right = x == width - 1 ? 0 : x + 1;
+  float share = 0.0;
+  if (occupancy[row + x] == 0) {
+    uint32_t adjacent = sum_adjacent(occupancy, up, row, down, left, x, right);
+    if (adjacent > 0) {
+      share = energy[row + x] / adjacent;
+    }
+  }
+  shares[row + x] = share;
+}
+
+/**
+ * Energy received by each occupant of a square.  Occupied neighbours offer a
+ * share of 0.
+ */
+inline void gain_at(const float *energy, const uint32_t *occupancy, const float *shares,
+                    float *gains, int width, int up, int row, int down, int x) {
+  const int left = x == 0 ? width - 1 : x - 1;
+  const int right = x == width - 1 ? 0 : x + 1;
+  float gain = 0.0;
+  if (occupancy[row + x] > 0) {
+    gain = energy[row + x] / occupancy[row + x] +
+           sum_adjacent(shares, up, row, down, left, x, right);
+  }
+  gains[row + x] = gain;
+}
+
+inline int row_above(int y, int width, int height) {
+  return (y == 0 ? height - 1 : y - 1) * width;
+}
+
+inline int row_below(int y, int width, int height) {
+  return (y == height - 1 ? 0 : y + 1) * width;
+}
+
+void shares_rows_scalar(int width, int height, int y_begin, int y_end,
+                        const float *energy, const uint32_t *occupancy, float *shares) {
+  for (int y = y_begin; y < y_end; ++y) {
+    const int up = row_above(y, width, height), row = y * width, down = row_below(y, width, height);
+    for (int x = 0; x < width; ++x) {
+      share_at(energy, occupancy, shares, width, up, row, down, x);
+    }
+  }
+}
+
+void gains_rows_scalar(int width, int height, int y_begin, int y_end,
+                       const float *energy, const uint32_t *occupancy, const float *shares,
+                       float *gains) {
+  for (int y = y_begin; y < y_end; ++y) {
+    const int up = row_above(y, width, height), row = y * width, down = row_below(y, width, height);
+    for (int x = 0; x < width; ++x) {
+      gain_at(energy, occupancy, shares, gains, width, up, row, down, x);
+    }
+  }
+}
+
+void apply_gains_scalar(size_t n, const uint32_t *cells, const uint32_t *dna_sizes, const float *gains,
+                        float cost_of_living, float cost_of_opcode, float *energies) {
+  for (size_t i = 0; i < n; ++i) {
+    energies[i] += gains[cells[i]] - (cost_of_living + cost_of_opcode * dna_sizes[i]);
+  }
+}
+
+
+#if EVOL_ENERGY_KERNEL_X86
+
+////////////////////////////////////////////////////////////////////////////
+// SSE4.1: 4 squares/lifeforms at a time
+
+__attribute__((target("sse4.1")))
+void shares_rows_sse41(int width, int height, int y_begin, int y_end,
+                       const float *energy, const uint32_t *occupancy, float *shares) {
+  const __m128i zero = _mm_setzero_si128();
+
+  for (int y = y_begin; y < y_end; ++y) {
+    const int up = row_above(y, width, height), row = y * width, down = row_below(y, width, height);
+    share_at(energy, occupancy, shares, width, up, row, down, 0);
+    int x = 1;
+    for (; x + 4 <= width - 1; x += 4) {
+      const uint32_t *o = occupancy + x;
+      __m128i adjacent = _mm_add_epi32(
+          _mm_add_epi32(
+              _mm_add_epi32(_mm_loadu_si128((const __m128i *)(o + up - 1)),
+                            _mm_loadu_si128((const __m128i *)(o + up))),
+              _mm_add_epi32(_mm_loadu_si128((const __m128i *)(o + up + 1)),
+                            _mm_loadu_si128((const __m128i *)(o + row - 1)))),
+          _mm_add_epi32(
+              _mm_add_epi32(_mm_loadu_si128((const __m128i *)(o + row + 1)),
+                            _mm_loadu_si128((const __m128i *)(o + down - 1))),
+              _mm_add_epi32(_mm_loadu_si128((const __m128i *)(o + down)),
+                            _mm_loadu_si128((const __m128i *)(o + down + 1)))));
+      __m128i here = _mm_loadu_si128((const __m128i *)(o + row));
+      __m128i give = _mm_andnot_si128(_mm_cmpeq_epi32(adjacent, zero), _mm_cmpeq_epi32(here, zero));
+      __m128 share = _mm_div_ps(_mm_loadu_ps(energy + row + x), _mm_cvtepi32_ps(adjacent));
+      _mm_storeu_ps(shares + row + x, _mm_and_ps(_mm_castsi128_ps(give), share));
+    }
+    for (; x < width; ++x) {
+      share_at(energy, occupancy, shares, width, up, row, down, x);
+    }
+  }
+}
+
+__attribute__((target("sse4.1")))
+void gains_rows_sse41(int width, int height, int y_begin, int y_end,
+                      const float *energy, const uint32_t *occupancy, const float *shares,
+                      float *gains) {
+  const __m128i zero = _mm_setzero_si128();
+
+  for (int y = y_begin; y < y_end; ++y) {
+    const int up = row_above(y, width, height), row = y * width, down = row_below(y, width, height);
+    gain_at(energy, occupancy, shares, gains, width, up, row, down, 0);
+    int x = 1;
+    for (; x + 4 <= width - 1; x += 4) {
+      const float *s = shares + x;
+      __m128 sum = _mm_loadu_ps(s + up - 1);
+      sum = _mm_add_ps(sum, _mm_loadu_ps(s + up));
+      sum = _mm_add_ps(sum, _mm_loadu_ps(s + up + 1));
+      sum = _mm_add_ps(sum, _mm_loadu_ps(s + row - 1));
+      sum = _mm_add_ps(sum, _mm_loadu_ps(s + row + 1));
+      sum = _mm_add_ps(sum, _mm_loadu_ps(s + down - 1));
+      sum = _mm_add_ps(sum, _mm_loadu_ps(s + down));
+      sum = _mm_add_ps(sum, _mm_loadu_ps(s + down + 1));
+      __m128i here = _mm_loadu_si128((const __m128i *)(occupancy + row + x));
+      __m128 own = _mm_div_ps(_mm_loadu_ps(energy + row + x), _mm_cvtepi32_ps(here));
+      __m128 occupied = _mm_castsi128_ps(_mm_cmpeq_epi32(here, zero));
+      _mm_storeu_ps(gains + row + x, _mm_andnot_ps(occupied, _mm_add_ps(own, sum)));
+    }
+    for (; x < width; ++x) {
+      gain_at(energy, occupancy, shares, gains, width, up, row, down, x);
+    }
+  }
+}
+
+__attribute__((target("sse4.1")))
+void apply_gains_sse41(size_t n, const uint32_t *cells, const uint32_t *dna_sizes, const float *gains,
+                       float cost_of_living, float cost_of_opcode, float *energies) {
+  const __m128 living = _mm_set1_ps(cost_of_living);
+  const __m128 opcode = _mm_set1_ps(cost_of_opcode);
+
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i c = _mm_loadu_si128((const __m128i *)(cells + i));
+    __m128 gain = _mm_set_ps(gains[_mm_extract_epi32(c, 3)], gains[_mm_extract_epi32(c, 2)],
+                             gains[_mm_extract_epi32(c, 1)], gains[_mm_extract_epi32(c, 0)]);
+    __m128 size = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(dna_sizes + i)));
+    __m128 cost = _mm_add_ps(living, _mm_mul_ps(opcode, size));
+    __m128 e = _mm_loadu_ps(energies + i);
+    _mm_storeu_ps(energies + i, _mm_add_ps(e, _mm_sub_ps(gain, cost)));
+  }
+  apply_gains_scalar(n - i, cells + i, dna_sizes + i, gains, cost_of_living, cost_of_opcode, energies + i);
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// AVX2: 8 squares/lifeforms at a time
+
+__attribute__((target("avx2")))
+void shares_rows_avx2(int width, int height, int y_begin, int y_end,
+                      const float *energy, const uint32_t *occupancy, float *shares) {
+  const __m256i zero = _mm256_setzero_si256();
+
+  for (int y = y_begin; y < y_end; ++y) {
+    const int up = row_above(y, width, height), row = y * width, down = row_below(y, width, height);
+    share_at(energy, occupancy, shares, width, up, row, down, 0);
+    int x = 1;
+    for (; x + 8 <= width - 1; x += 8) {
+      const uint32_t *o = occupancy + x;
+      __m256i adjacent = _mm256_add_epi32(
+          _mm256_add_epi32(
+              _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(o + up - 1)),
+                               _mm256_loadu_si256((const __m256i *)(o + up))),
+              _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(o + up + 1)),
+                               _mm256_loadu_si256((const __m256i *)(o + row - 1)))),
+          _mm256_add_epi32(
+              _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(o + row + 1)),
+                               _mm256_loadu_si256((const __m256i *)(o + down - 1))),
+              _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(o + down)),
+                               _mm256_loadu_si256((const __m256i *)(o + down + 1)))));
+      __m256i here = _mm256_loadu_si256((const __m256i *)(o + row));
+      __m256i give = _mm256_andnot_si256(_mm256_cmpeq_epi32(adjacent, zero),
+                                         _mm256_cmpeq_epi32(here, zero));
+      __m256 share = _mm256_div_ps(_mm256_loadu_ps(energy + row + x), _mm256_cvtepi32_ps(adjacent));
+      _mm256_storeu_ps(shares + row + x, _mm256_and_ps(_mm256_castsi256_ps(give), share));
+    }
+    for (; x < width; ++x) {
+      share_at(energy, occupancy, shares, width, up, row, down, x);
+    }
+  }
+}
+
+__attribute__((target("avx2")))
+void gains_rows_avx2(int width, int height, int y_begin, int y_end,
+                     const float *energy, const uint32_t *occupancy, const float *shares,
+                     float *gains) {
+  const __m256i zero = _mm256_setzero_si256();
+
+  for (int y = y_begin; y < y_end; ++y) {
+    const int up = row_above(y, width, height), row = y * width, down = row_below(y, width, height);
+    gain_at(energy, occupancy, shares, gains, width, up, row, down, 0);
+    int x = 1;
+    for (; x + 8 <= width - 1; x += 8) {
+      const float *s = shares + x;
+      __m256 sum = _mm256_loadu_ps(s + up - 1);
+      sum = _mm256_add_ps(sum, _mm256_loadu_ps(s + up));
+      sum = _mm256_add_ps(sum, _mm256_loadu_ps(s + up + 1));
+      sum = _mm256_add_ps(sum, _mm256_loadu_ps(s + row - 1));
+      sum = _mm256_add_ps(sum, _mm256_loadu_ps(s + row + 1));
+      sum = _mm256_add_ps(sum, _mm256_loadu_ps(s + down - 1));
+      sum = _mm256_add_ps(sum, _mm256_loadu_ps(s + down));
+      sum = _mm256_add_ps(sum, _mm256_loadu_ps(s + down + 1));
+      __m256i here = _mm256_loadu_si256((const __m256i *)(occupancy + row + x));
+      __m256 own = _mm256_div_ps(_mm256_loadu_ps(energy + row + x), _mm256_cvtepi32_ps(here));
+      __m256 occupied = _mm256_castsi256_ps(_mm256_cmpeq_epi32(here, zero));
+      _mm256_storeu_ps(gains + row + x, _mm256_andnot_ps(occupied, _mm256_add_ps(own, sum)));
+    }
+    for (; x < width; ++x) {
+      gain_at(energy, occupancy, shares, gains, width, up, row, down, x);
+    }
+  }
+}
+
+__attribute__((target("avx2")))
+void apply_gains_avx2(size_t n, const uint32_t *cells, const uint32_t *dna_sizes, const float *gains,
+                      float cost_of_living, float cost_of_opcode, float *energies) {
+  const __m256 living = _mm256_set1_ps(cost_of_living);
+  const __m256 opcode = _mm256_set1_ps(cost_of_opcode);
+
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i c = _mm256_loadu_si256((const __m256i *)(cells + i));
+    __m256 gain = _mm256_i32gather_ps(gains, c, sizeof(float));
+    __m256 size = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(dna_sizes + i)));
+    __m256 cost = _mm256_add_ps(living, _mm256_mul_ps(opcode, size));
+    __m256 e = _mm256_loadu_ps(energies + i);
+    _mm256_storeu_ps(energies + i, _mm256_add_ps(e, _mm256_sub_ps(gain, cost)));
+  }
+  apply_gains_scalar(n - i, cells + i, dna_sizes + i, gains, cost_of_living, cost_of_opcode, energies + i);
+}
+
+#endif  // EVOL_ENERGY_KERNEL_X86
+
+}  // namespace anon
+
+
+EnergyKernel::Isa EnergyKernel::BestIsa() {
+  if (Supported(Isa::AVX2))
+    return Isa::AVX2;
+  if (Supported(Isa::SSE41))
+    return Isa::SSE41;
+  return Isa::SCALAR;
+}
+
+
+bool EnergyKernel::Supported(Isa isa) {
+  switch (isa) {
+    case Isa::SCALAR:
+      return true;
+#if EVOL_ENERGY_KERNEL_X86
+    case Isa::SSE41:
+      return __builtin_cpu_supports("sse4.1");
+    case Isa::AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+
+const char * EnergyKernel::IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::SCALAR:
+      return "scalar";
+    case Isa::SSE41:
+      return "SSE4.1";
+    case Isa::AVX2:
+      return "AVX2";
+  }
+  return "?UNKNOWN?";
+}
+
+
+EnergyKernel::EnergyKernel(Isa isa) : isa_(isa) {
+  if (!Supported(isa)) {
+    abort();
+  }
+
+  switch (isa) {
+#if EVOL_ENERGY_KERNEL_X86
+    case Isa::AVX2:
+      compute_shares_ = shares_rows_avx2;
+      compute_gains_ = gains_rows_avx2;
+      apply_gains_ = apply_gains_avx2;
+      break;
+    case Isa::SSE41:
+      compute_shares_ = shares_rows_sse41;
+      compute_gains_ = gains_rows_sse41;
+      apply_gains_ = apply_gains_sse41;
+      break;
+#endif
+    default:
+      compute_shares_ = shares_rows_scalar;
+      compute_gains_ = gains_rows_scalar;
+      apply_gains_ = apply_gains_scalar;
+      break;
+  }
+}
+
+
+}  // namespace evol
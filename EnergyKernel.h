@@ -0,0 +1,107 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_ENERGY_KERNEL_H_
+#define EVOL_ENERGY_KERNEL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace evol {
+
+
+/**
+ * The number-crunching half of an engine's energy step, in several flavors of
+ * SIMD.  The flavor is picked at runtime from what the CPU supports; all of
+ * them perform the same float operations in the same order as the scalar
+ * code, so they agree with it to the bit.
+ *
+ * All planes are row-major width x height arrays, as laid out by Grid.
+ */
+class EnergyKernel {
+ public:
+  enum class Isa { SCALAR = 0, SSE41, AVX2 };
+
+  /**
+   * Return the best instruction set this CPU supports.
+   */
+  static Isa BestIsa();
+
+  /**
+   * Return true if this CPU (and build) can run the given instruction set.
+   */
+  static bool Supported(Isa isa);
+
+  /**
+   * Return a human-readable name for the given instruction set.
+   */
+  static const char * IsaName(Isa isa);
+
+  /**
+   * Use the given instruction set, which must be Supported().
+   */
+  explicit EnergyKernel(Isa isa = BestIsa());
+
+  Isa GetIsa() const { return isa_; }
+
+  /**
+   * Work out how much energy each occupant of each square receives: an even
+   * split of its own square's energy, plus a share of each adjacent empty
+   * square's energy (which is split evenly between all the lifeforms adjacent
+   * to it).  Unoccupied squares receive 0.  shares is scratch space.
+   */
+  void ComputeGains(int width, int height, const float *energy, const uint32_t *occupancy,
+                    float *shares, float *gains) const {
+    ComputeShares(width, height, 0, height, energy, occupancy, shares);
+    ComputeGains(width, height, 0, height, energy, occupancy, shares, gains);
+  }
+
+  /**
+   * The two passes of ComputeGains() over rows [y_begin, y_end) only, so
+   * horizontal strips of the arena can be done on different threads.  Each
+   * row reads the rows above and below it, so every strip's shares must be
+   * complete before any strip's gains are computed.
+   */
+  void ComputeShares(int width, int height, int y_begin, int y_end, const float *energy,
+                     const uint32_t *occupancy, float *shares) const {
+    compute_shares_(width, height, y_begin, y_end, energy, occupancy, shares);
+  }
+
+  void ComputeGains(int width, int height, int y_begin, int y_end, const float *energy,
+                    const uint32_t *occupancy, const float *shares, float *gains) const {
+    compute_gains_(width, height, y_begin, y_end, energy, occupancy, shares, gains);
+  }
+
+  /**
+   * Hand each of n lifeforms its square's gain and deduct its cost of
+   * living in the same sweep:
+   *
+   *   energies[i] += gains[cells[i]] - (cost_of_living + cost_of_opcode * dna_sizes[i])
+   */
+  void ApplyGains(size_t n, const uint32_t *cells, const uint32_t *dna_sizes, const float *gains,
+                  float cost_of_living, float cost_of_opcode, float *energies) const {
+    apply_gains_(n, cells, dna_sizes, gains, cost_of_living, cost_of_opcode, energies);
+  }
+
+ private:
+  typedef void (*ComputeSharesFn)(int, int, int, int, const float *, const uint32_t *, float *);
+  typedef void (*ComputeGainsFn)(int, int, int, int, const float *, const uint32_t *, const float *,
+                                 float *);
+  typedef void (*ApplyGainsFn)(size_t, const uint32_t *, const uint32_t *, const float *,
+                               float, float, float *);
+
+  Isa isa_;
+  ComputeSharesFn compute_shares_;
+  ComputeGainsFn compute_gains_;
+  ApplyGainsFn apply_gains_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_ENERGY_KERNEL_H_
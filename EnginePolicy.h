@@ -0,0 +1,81 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_ENGINE_POLICY_H_
+#define EVOL_ENGINE_POLICY_H_
+
+#include "Config.h"
+#include "Coord.h"
+#include "Params.h"
+
+namespace evol {
+
+
+/**
+ * Engine policies supply the constants used by an engine's inner loops.
+ * Every accessor takes the engine's Config: DynamicPolicy reads the value
+ * from it, while FixedPolicy ignores it and returns a compile-time constant
+ * which the compiler folds into the loop, as it did when these were all
+ * Params.
+ *
+ * EvolEngine instantiates its turn for each policy listed in its dispatch
+ * table and, at startup, picks the first whose Matches() accepts the Config.
+ */
+struct DynamicPolicy {
+  static bool Matches(const Config &) { return true; }
+
+  static Unit Width(const Config & c) { return c.width; }
+  static Unit Height(const Config & c) { return c.height; }
+  static float CostOfLiving(const Config & c) { return c.cost_of_living; }
+  static float CostOfOpcode(const Config & c) { return c.cost_of_opcode; }
+  static float MeiosisLevel(const Config & c) { return c.meiosis_level; }
+  static float MeiosisCost(const Config & c) { return c.meiosis_cost; }
+  static float RandomMoveCost(const Config & c) { return c.random_move_cost; }
+};
+
+
+/**
+ * Params energy costs on a W x H arena.  W and H should be powers of two, so
+ * wrapping around the arena edge is a mask (see Wrap()).
+ */
+template <Unit W, Unit H>
+struct FixedPolicy {
+  static bool Matches(const Config & c) {
+    return c.width == W && c.height == H &&
+           c.cost_of_living == Params::kCostOfLiving &&
+           c.cost_of_opcode == Params::kCostOfOpcode &&
+           c.meiosis_level == Params::kMeiosisLevel &&
+           c.meiosis_cost == Params::kMeiosisCost &&
+           c.random_move_cost == Params::kRandomMoveCost;
+  }
+
+  static Unit Width(const Config &) { return W; }
+  static Unit Height(const Config &) { return H; }
+  static float CostOfLiving(const Config &) { return Params::kCostOfLiving; }
+  static float CostOfOpcode(const Config &) { return Params::kCostOfOpcode; }
+  static float MeiosisLevel(const Config &) { return Params::kMeiosisLevel; }
+  static float MeiosisCost(const Config &) { return Params::kMeiosisCost; }
+  static float RandomMoveCost(const Config &) { return Params::kRandomMoveCost; }
+};
+
+
+/**
+ * Wrap v, which is at most one step outside [0, size), back into range.
+ * When size is a compile-time power of two this folds down to a mask.
+ */
+inline Unit Wrap(Unit v, Unit size) {
+  if ((size & (size - 1)) == 0) {
+    return v & (size - 1);
+  }
+  return v < 0 ? v + size : (v >= size ? v - size : v);
+}
+
+
+}  // namespace evol
+#endif  // EVOL_ENGINE_POLICY_H_
@@ -12,216 +12,603 @@
 #include <sys/time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 #include "Action.h"
+#include "Checkpoint.h"
 #include "Coord.h"
+#include "DecisionTable.h"
+#include "EnginePolicy.h"
 #include "Lifeform.h"
+#include "LifeformStore.h"
+#include "Mutation.h"
 #include "Random.h"
+#include "Span.h"
+#include "ThreadPool.h"
 #include "Timer.h"
 #include "Types.h"
 
 namespace evol {
 
 
+namespace {
+
+/**
+ * Engine specializations, most specific first.  The last entry matches any
+ * Config.
+ */
+struct EngineInstantiation {
+  bool (*matches)(const Config &);
+  void (EvolEngine::*run_turns)(Timer &);
+  const char *name;
+};
+
+}  // namespace anon
+
+
+// Defined here rather than in the header as it needs access to the private
+// RunTurns() instantiations
+struct EvolEngine::Dispatch {
+  template <typename Policy>
+  static EngineInstantiation Entry(const char *name) {
+    return {&Policy::Matches, &EvolEngine::RunTurns<Policy>, name};
+  }
+
+  static const EngineInstantiation * Find(const Config & config) {
+    static const EngineInstantiation kInstantiations[] = {
+      Entry<FixedPolicy<64, 64>>("64x64 fixed"),
+      Entry<FixedPolicy<128, 128>>("128x128 fixed"),
+      Entry<FixedPolicy<256, 256>>("256x256 fixed"),
+      Entry<DynamicPolicy>("generic"),
+    };
+    for (auto & inst : kInstantiations) {
+      if (inst.matches(config)) {
+        return &inst;
+      }
+    }
+    abort();  // DynamicPolicy matches everything
+  }
+};
+
+
+EvolEngine::EvolEngine(const Config & config, Asteroid * asteroid, unsigned index,
+                       unsigned num_engines)
+    : do_exit_(false),
+      finished_(false),
+      arena_(new Arena(config.width, config.height)),
+      config_(config),
+      turns_(0),
+      max_turns_(0),
+      lifeform_updates_(0),
+      run_seconds_(0.0),
+      index_(index),
+      rng_(Random::Generator().Next()),
+      asteroid_(asteroid) {
+  const EngineInstantiation * inst = Dispatch::Find(config);
+  run_turns_ = inst->run_turns;
+  policy_name_ = inst->name;
+  arena_->SetIdSequence(index + 1, num_engines);
+}
+
+
 void EvolEngine::Seed(unsigned num_lifeforms) {
+  ScopedGenerator sg(rng_);
+  GenomeRef genome = arena_->Genomes().Intern(Dna{OpCode::FINAL_MOVE_RANDOM});
+
   for (unsigned i = 0; i < num_lifeforms; i++) {
-    for (;;) {
-      Coord c = arena_->GetRandomCoordOnArena();
-      arena_->AddLifeform(make_lifeform(0, Dna {OpCode::FINAL_MOVE_RANDOM}), c);
-      break;
-    }
+    Coord c = arena_->GetRandomCoordOnArena();
+    arena_->AddLifeform(0, genome, 1.0, c);
   }
 }
 
 
 void EvolEngine::Run() {
   Timer loop_timer("Main loop");
+  auto start = std::chrono::steady_clock::now();
 
   {
     std::lock_guard<std::mutex> lg(mutex_);
     timers_.assign({&loop_timer});
   }
 
-  while (!do_exit_) {
+  {
+    ScopedGenerator sg(rng_);
+
+    // Helpers for the parallel phases of each turn; they exit with the turn
+    // loop
+    ThreadPool workers(config_.worker_threads);
+    workers_ = &workers;
+    SetUpStrips();
+
+    (this->*run_turns_)(loop_timer);
+    workers_ = nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lg(mutex_);
+    run_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    finished_ = true;
+
+    // Clear out the timer export before they fall out of scope
+    timers_.clear();
+  }
+
+  if (pause_ != nullptr) {
+    pause_->Leave(index_);
+  }
+}
+
+
+void EvolEngine::SaveCheckpoint(CheckpointWriter & out) const {
+  out.Put(turns_);
+  out.Put(lifeform_updates_);
+  out.Put(rng_.State());
+  out.PutArray(random_moves_.Remaining());
+  out.PutArray(mutation_.Remaining());
+  arena_->SaveCheckpoint(out);
+}
+
+
+bool EvolEngine::RestoreCheckpoint(CheckpointReader & in) {
+  std::array<uint64_t, 4> state;
+  std::vector<ActionType> moves;
+  std::vector<uint32_t> mutation_draws;
+  if (!in.Get(&turns_) || !in.Get(&lifeform_updates_) || !in.Get(&state) ||
+      !in.GetArray(&moves, decltype(random_moves_)::kSize) ||
+      !in.GetArray(&mutation_draws, Mutation::Batch::kSize)) {
+    return false;
+  }
+  if (state == std::array<uint64_t, 4>{}) {
+    return in.Fail("bad random stream");  // xoshiro's one bad state
+  }
+  for (ActionType move : moves) {
+    if (int32_t(move) < kActionMoveBegin || int32_t(move) > kActionMoveEnd) {
+      return in.Fail("bad random move");
+    }
+  }
+  rng_.SetState(state);
+  random_moves_.SetRemaining(moves);
+  mutation_.SetRemaining(mutation_draws);
+  return arena_->RestoreCheckpoint(in);
+}
+
+
+void EvolEngine::SetUpStrips() {
+  const Unit height = arena_->Height();
+  num_strips_ = 1;
+  if (workers_->NumThreads() > 1) {
+    num_strips_ = std::min<unsigned>(height, workers_->NumThreads() * Params::kStripsPerWorker);
+  }
+
+  strip_rows_.resize(num_strips_ + 1);
+  row_strips_.resize(height);
+  for (unsigned s = 0; s <= num_strips_; ++s) {
+    strip_rows_[s] = uint64_t(s) * height / num_strips_;
+  }
+  for (unsigned s = 0; s < num_strips_; ++s) {
+    std::fill(row_strips_.begin() + strip_rows_[s], row_strips_.begin() + strip_rows_[s + 1], s);
+  }
+}
+
+
+template <typename Fn>
+void EvolEngine::ForEachStrip(Fn fn) {
+  auto strips = [this, &fn](size_t begin, size_t end) {
+    for (size_t s = begin; s < end; ++s) {
+      fn(s, strip_rows_[s], strip_rows_[s + 1]);
+    }
+  };
+  workers_->ParallelFor(num_strips_, 1, strips);
+}
+
+
+template <typename Fn>
+void EvolEngine::ForEachSlice(size_t n, Fn fn) {
+  auto slices = [this, n, &fn](size_t begin, size_t end) {
+    for (size_t s = begin; s < end; ++s) {
+      fn(s, n * s / num_strips_, n * (s + 1) / num_strips_);
+    }
+  };
+  workers_->ParallelFor(num_strips_, 1, slices);
+}
+
+
+template <typename Pred>
+void EvolEngine::FindLifeforms(Pred pred, std::vector<LifeformIndex> & found) {
+  slice_found_.resize(num_strips_);
+  ForEachSlice(arena_->NumLifeforms(), [this, &pred](unsigned slice, size_t begin, size_t end) {
+    std::vector<LifeformIndex> & out = slice_found_[slice];
+    out.clear();
+    for (LifeformIndex lf = begin; lf < end; ++lf) {
+      if (pred(lf)) {
+        out.push_back(lf);
+      }
+    }
+  });
+  found.clear();
+  for (const auto & out : slice_found_) {
+    found.insert(found.end(), out.begin(), out.end());
+  }
+}
+
+
+template <typename Policy>
+void EvolEngine::RunTurns(Timer & loop_timer) {
+  while (!do_exit_ && (max_turns_ == 0 || turns_ < max_turns_)) {
+    if (pause_ != nullptr && pause_->CheckIn(index_, turns_)) {
+      // Leave the random stream where a checkpoint can see it, and stop
+      // if we were told to while paused
+      rng_ = Random::Generator();
+      pause_->Wait(turns_);
+      if (do_exit_) {
+        break;
+      }
+    }
+
     std::unique_lock<std::mutex> vl(mutex_, std::defer_lock);
 
     // Start main loop timer
     loop_timer.StartCollection();
 
     // Run each Lifeform's Dna and get its resulting action.  These actions
-    // make no change to the arena and will be resolved later in the loop
-    std::forward_list<Action> actions;
-    for (auto & lf : arena_->Lifeforms()) {
-      actions.push_front(Action(lf, lf->RunDna(arena_.get())));
-    }
-
-    // Map and resolve all actions
-    ActionMap interactions{MapActions(actions)};
+    // make no change to the arena and will be resolved later in the loop,
+    // so the lifeforms are split between the evaluation threads
+    ForEachStrip([this](unsigned, Unit first_row, Unit end_row) {
+      arena_->UpdateOccupiedRows(first_row, end_row);
+    });
+    ForEachStrip([this](unsigned, Unit first_row, Unit end_row) {
+      arena_->UpdateSensorRows(first_row, end_row);
+    });
+    actions_.resize(arena_->NumLifeforms());
+    auto evaluate = [this](size_t begin, size_t end) {
+      for (size_t lf = begin; lf < end; ++lf) {
+        actions_[lf] = Action(lf, RunDna(lf));
+      }
+    };
+    workers_->ParallelFor(actions_.size(), Params::kEvalChunkSize, evaluate);
 
     // Time to update the arena and birth/kill lifeforms; take the main lock
     vl.lock();
 
-    ResolveInteractions(interactions);
+    // Map and resolve all actions
+    MapActions<Policy>();
+
+    ResolveInteractions();
 
     // Handle energy and replication
-    ApplyEnergyLevelsToLifeforms();
+    ApplyEnergyLevelsToLifeforms<Policy>();
 
     // Handle birth & death
     KillStarvedLifeforms();
-    SplitFatLifeforms();
+    SplitFatLifeforms<Policy>();
+
+    const uint64_t launch_interval = config_.lifeform_asteroid_launch_interval;
+    const uint64_t land_interval = config_.lifeform_asteroid_land_interval;
+    bool launch = launch_interval != 0 && turns_ % launch_interval == 0;
+    bool land = land_interval != 0 && turns_ % land_interval == 0;
+    if (launch || land) {
+      // Blast some lifeforms off into outer space!  (Actually another engine)
+      migrants_.clear();
+      for (int i = 0; launch && i < config_.migration_batch; ++i) {
+        Lifeform lf = arena_->RemoveRandomLifeform();
+        if (!lf) {
+          break;
+        }
+        migrants_.push_back(lf);
+      }
 
-    // Blast a lifeform off into outer space!  (Actually another engine)
-    if (Params::kLifeformAsteroidLaunchInterval != 0 && turns_ % Params::kLifeformAsteroidLaunchInterval == 0) {
-      auto lf = arena_->RemoveRandomLifeform();
-      if (lf) {
-        asteroid_->LaunchLifeform(lf);
+      if (asteroid_->Lockstep()) {
+        // Every engine meets at the asteroid on the same turns, so exchanges
+        // don't depend on thread timing.  Don't hold up readers meanwhile.
+        vl.unlock();
+        asteroid_->Exchange(index_, migrants_, land);
+        vl.lock();
+      } else {
+        asteroid_->Launch(index_, migrants_);
+        if (land) {
+          asteroid_->Land(index_, migrants_);
+        }
       }
-    }
 
-    // Get a lifeform from outer space!  (Actually another engine)
-    if (Params::kLifeformAsteroidLandInterval != 0 && turns_ % Params::kLifeformAsteroidLandInterval == 0) {
-      auto lf = asteroid_->LandLifeform();
-      if (lf) {
+      // Get some lifeforms from outer space!  Along with any which couldn't
+      // leave
+      for (const Lifeform & lf : migrants_) {
         Coord c(arena_->GetRandomCoordOnArena());
         arena_->AddLifeform(lf, c);
       }
+      migrants_.clear();
     }
 
     // End main loop timer
     loop_timer.EndCollection();
     ++turns_;
+    lifeform_updates_ += actions_.size();
   }
+}
 
-  // Clear out the timer export before they fall out of scope
-  timers_.clear();
+
+ActionType EvolEngine::RunDna(LifeformIndex lf) const {
+  const LifeformStore & lifeforms = arena_->Lifeforms();
+  const DecisionTable & table = lifeforms.GetTable(lf);
+
+  return table.Lookup(arena_->Sense(lifeforms.GetCoord(lf), table.Sensors()));
 }
 
 
-ActionMap EvolEngine::MapActions(const std::forward_list<Action> & actions) const {
-  ActionMap interactions{ActionMap()};
-  for (auto act : actions) {
-    // We place each action into a map of coords -> actions for later
-    // resolution
-    Coord dest;
-    switch (act.type) {
-      case ActionType::NOTHING:
-        dest = act.actor->GetCoord();
-        break;
-      case ActionType::APOPTOSIS:
-        dest = act.actor->GetCoord();
-        break;
-      case ActionType::MOVE_NORTH:
-        dest = act.actor->GetCoord().North();
-        break;
-      case ActionType::MOVE_SOUTH:
-        dest = act.actor->GetCoord().South();
-        break;
-      case ActionType::MOVE_EAST:
-        dest = act.actor->GetCoord().East();
-        break;
-      case ActionType::MOVE_WEST:
-        dest = act.actor->GetCoord().West();
-        break;
+template <typename Policy>
+void EvolEngine::MapActions() {
+  LifeformStore & lifeforms = arena_->Lifeforms();
+  const Unit width = Policy::Width(config_);
+  const Unit height = Policy::Height(config_);
+  const unsigned strips = num_strips_;
+  const size_t num_actions = actions_.size();
+
+  // Random moves take their directions in lifeform order, as if drawn one
+  // at a time; count them per slice to find where each slice's start
+  slice_moves_.assign(strips + 1, 0);
+  ForEachSlice(num_actions, [this](unsigned slice, size_t begin, size_t end) {
+    uint32_t moves = 0;
+    for (size_t i = begin; i < end; ++i) {
+      moves += actions_[i].type == ActionType::MOVE_RANDOM;
     }
-    interactions[dest].emplace_back(act);
+    slice_moves_[slice + 1] = moves;
+  });
+  for (unsigned s = 0; s < strips; ++s) {
+    slice_moves_[s + 1] += slice_moves_[s];
   }
-  return interactions;
+  move_draws_.resize(slice_moves_[strips]);
+  for (ActionType & move : move_draws_) {
+    move = random_moves_.Next();
+  }
+
+  // Count each slice's actions per source and destination strip
+  action_cells_.resize(num_actions);
+  source_counts_.assign(strips * strips, 0);
+  dest_counts_.assign(strips * strips, 0);
+  ForEachSlice(num_actions, [&](unsigned slice, size_t begin, size_t end) {
+    const ActionType * move = move_draws_.data() + slice_moves_[slice];
+    uint32_t * sources = &source_counts_[slice * strips];
+    uint32_t * dests = &dest_counts_[slice * strips];
+    for (size_t i = begin; i < end; ++i) {
+      Action & act = actions_[i];
+      if (act.type == ActionType::MOVE_RANDOM) {
+        // Dna evaluation is read-only, so the move is paid for here
+        lifeforms.SetEnergy(act.actor, lifeforms.GetEnergy(act.actor) - Policy::RandomMoveCost(config_));
+        act.type = *move++;
+      }
+      Coord pos = lifeforms.GetCoord(act.actor);
+      Unit x = pos.x, y = pos.y;
+      switch (act.type) {
+        case ActionType::NOTHING:
+          // Nothing to resolve
+          continue;
+        case ActionType::APOPTOSIS:
+          break;
+        case ActionType::MOVE_NORTH:
+          y = Wrap(y - 1, height);
+          break;
+        case ActionType::MOVE_SOUTH:
+          y = Wrap(y + 1, height);
+          break;
+        case ActionType::MOVE_EAST:
+          x = Wrap(x + 1, width);
+          break;
+        case ActionType::MOVE_WEST:
+          x = Wrap(x - 1, width);
+          break;
+        case ActionType::MOVE_RANDOM:
+          // Replaced by a direction above; should never happen
+          abort();
+      }
+      ++sources[row_strips_[pos.y]];
+      ++dests[row_strips_[y]];
+      action_cells_[i] = y * width + x;
+    }
+  });
+
+  // Turn the counts into cursors: strip by strip, and within a strip slice
+  // by slice, so every bucket keeps lifeform order
+  uint32_t num_sources = 0, num_dests = 0;
+  strip_offsets_.resize(strips);
+  dest_offsets_.resize(strips);
+  for (unsigned strip = 0; strip < strips; ++strip) {
+    for (unsigned slice = 0; slice < strips; ++slice) {
+      const size_t i = slice * strips + strip;
+      const uint32_t source = source_counts_[i], dest = dest_counts_[i];
+      source_counts_[i] = num_sources;
+      num_sources += source;
+      dest_counts_[i] = num_dests;
+      num_dests += dest;
+    }
+    strip_offsets_[strip] = num_sources;
+    dest_offsets_[strip] = num_dests;
+  }
+
+  // Scatter each slice's actions into the source strips' buckets, and their
+  // indices into the destination strips'
+  strip_actions_.resize(num_sources);
+  dest_order_.resize(num_dests);
+  ForEachSlice(num_actions, [&](unsigned slice, size_t begin, size_t end) {
+    uint32_t * sources = &source_counts_[slice * strips];
+    uint32_t * dests = &dest_counts_[slice * strips];
+    for (size_t i = begin; i < end; ++i) {
+      const Action & act = actions_[i];
+      if (act.type == ActionType::NOTHING) {
+        continue;
+      }
+      strip_actions_[sources[row_strips_[lifeforms.GetCoord(act.actor).y]]++] = act;
+      dest_order_[dests[row_strips_[action_cells_[i] / width]]++] = i;
+    }
+  });
+
+  // Each strip counting-sorts the actions landing in it over its own
+  // squares.  cell_offsets_[cell] is used as the insertion cursor, leaving
+  // it pointing at the end of the bucket (i.e. the start of the next one)
+  // when we're done.
+  cell_offsets_.resize(arena_->NumCells());
+  sorted_actions_.resize(num_dests);
+  ForEachStrip([&](unsigned strip, Unit first_row, Unit end_row) {
+    uint32_t * offsets = cell_offsets_.data() + size_t(first_row) * width;
+    const size_t num_cells = size_t(end_row - first_row) * width;
+    const uint32_t begin = strip == 0 ? 0 : dest_offsets_[strip - 1];
+    const uint32_t end = dest_offsets_[strip];
+    if (begin == end) {
+      std::fill(offsets, offsets + num_cells, begin);
+      return;
+    }
+
+    std::fill(offsets, offsets + num_cells, 0);
+    for (uint32_t k = begin; k < end; ++k) {
+      ++cell_offsets_[action_cells_[dest_order_[k]]];
+    }
+    uint32_t offset = begin;
+    for (size_t cell = 0; cell < num_cells; ++cell) {
+      const uint32_t count = offsets[cell];
+      offsets[cell] = offset;
+      offset += count;
+    }
+    for (uint32_t k = begin; k < end; ++k) {
+      const uint32_t i = dest_order_[k];
+      sorted_actions_[cell_offsets_[action_cells_[i]]++] = actions_[i];
+    }
+  });
 }
 
 
 /**
- * Commit the resolved interactions of each lifeform.
+ * Commit the resolved interactions of each lifeform.  After MapActions(),
+ * strip N's actors end at strip_offsets_[N] and square N's actions end at
+ * cell_offsets_[N]; each starts where number N - 1's end.
+ *
+ * Lifting a lifeform or killing it only touches its own square, and placing
+ * it only its new one, so each thread may do this for its own strip's squares
+ * while the others do theirs.
  */
-void EvolEngine::ResolveInteractions(ActionMap & interactions) {
-  for (auto & elem : interactions) {
-    auto & coord = elem.first;
-    auto & actions = elem.second;
-    for (auto & act: actions) {
+void EvolEngine::ResolveInteractions() {
+  ForEachStrip([this](unsigned strip, Unit, Unit) {
+    for (size_t i = strip == 0 ? 0 : strip_offsets_[strip - 1]; i < strip_offsets_[strip]; ++i) {
+      const Action & act = strip_actions_[i];
       if (act.type == ActionType::APOPTOSIS) {
-        arena_->RemoveLifeform(act.actor);
-      } else if (act.type != ActionType::NOTHING) {
-        arena_->MoveLifeform(act.actor, coord);
+        arena_->KillLifeform(act.actor);
+      } else {
+        arena_->LiftLifeform(act.actor);
       }
     }
-  }
+  });
+
+  const Unit width = arena_->Width();
+  ForEachStrip([this, width](unsigned, Unit first_row, Unit end_row) {
+    size_t begin = first_row == 0 ? 0 : cell_offsets_[first_row * width - 1];
+    for (size_t cell = first_row * width; cell < size_t(end_row) * width; ++cell) {
+      size_t end = cell_offsets_[cell];
+      if (begin == end) {
+        continue;
+      }
+      Coord coord = arena_->CellCoord(cell);
+      for (size_t i = begin; i < end; ++i) {
+        const Action & act = sorted_actions_[i];
+        if (act.type != ActionType::APOPTOSIS) {
+          arena_->PlaceLifeform(act.actor, coord);
+        }
+      }
+      begin = end;
+    }
+  });
 }
 
 
 /**
  * To calculate energy available to lifeforms, we iterate the entire arena.  For
  * each UNOCCUPIED square, energy is split evenly between adjacent lifeforms
- * (adjacency meaning being in a 9x9 grid around the square).  For each OCCUPIED
+ * (adjacency meaning being in a 3x3 grid around the square).  For each OCCUPIED
  * square, energy is split only among the occupants.
  *
+ * This is done in two row-major passes over flat planes: first every empty
+ * square works out the share it gives each adjacent lifeform, then every
+ * occupied square adds its own energy per occupant to the shares offered by
+ * its 8 neighbours.  Every lifeform then receives its square's total.  The
+ * arithmetic lives in EnergyKernel, which vectorizes it for the CPU at hand.
+ * Each pass is split into strips; the second needs the first's shares from
+ * the rows bordering its strip, so waits for every strip's to be done.
+ *
  * Finally, every lifeform loses a base amount of energy + (numbero of opcodes *
  * cost per opcode) every turn.  The opcode cost discourages large amounts of
  * junk Dna which consume CPU cycles.
  */
+template <typename Policy>
 void EvolEngine::ApplyEnergyLevelsToLifeforms() {
-  Coord c;
-  int width = arena_->Width();
-  int height = arena_->Height();
-
-  for (c.x = 0; c.x < width; c.x++) {
-    for (c.y = 0; c.y < height; c.y++) {
-      auto occupants = arena_->LifeformsAt(c);
-      float available_energy = arena_->GetEnergy(c);
-      float energy_share_per_lf = 0.0;
-
-      if (!occupants.empty()) {
-        energy_share_per_lf = available_energy / occupants.size();
-        for (auto & lf : occupants) {
-          lf->SetEnergy(lf->GetEnergy() + energy_share_per_lf);
-        }
-      } else {
-        // Split all of empty square's energy between adjacent occupants
-        auto adjacent = arena_->GetAdjacentLifeforms(c);
-        if (adjacent.empty()) {
-          continue;
-        }
-        energy_share_per_lf = available_energy / adjacent.size();
-        for (auto & lf : adjacent) {
-          lf->SetEnergy(lf->GetEnergy() + energy_share_per_lf);
-        }
-      }
-    }
-  }
-
-  // Deduct cost of living
-  for (auto & lf : arena_->Lifeforms()) {
-    float energy = lf->GetEnergy() - Params::kCostOfLiving - Params::kCostOfOpcode * lf->GetDnaSize();
-    lf->SetEnergy(energy);
-  }
+  const Unit width = Policy::Width(config_);
+  const Unit height = Policy::Height(config_);
+  const float *energy = arena_->EnergyPlane().data();
+  const uint32_t *occupancy = arena_->OccupancyPlane().data();
+  energy_shares_.resize(arena_->NumCells());
+  energy_gains_.resize(arena_->NumCells());
+  ForEachStrip([&](unsigned, Unit first_row, Unit end_row) {
+    energy_kernel_.ComputeShares(width, height, first_row, end_row, energy, occupancy,
+                                 energy_shares_.data());
+  });
+  ForEachStrip([&](unsigned, Unit first_row, Unit end_row) {
+    energy_kernel_.ComputeGains(width, height, first_row, end_row, energy, occupancy,
+                                energy_shares_.data(), energy_gains_.data());
+  });
+
+  // Hand out energy and deduct cost of living in the same sweep
+  LifeformStore & lifeforms = arena_->Lifeforms();
+  auto apply = [&](size_t begin, size_t end) {
+    energy_kernel_.ApplyGains(end - begin, lifeforms.Cells().data() + begin,
+                              lifeforms.DnaSizes().data() + begin, energy_gains_.data(),
+                              Policy::CostOfLiving(config_), Policy::CostOfOpcode(config_),
+                              lifeforms.Energies().data() + begin);
+  };
+  workers_->ParallelFor(lifeforms.Size(), Params::kEvalChunkSize, apply);
 }
 
 
+/**
+ * Sweep the energy column for the starved on the worker threads, then kill
+ * them and compact every dead lifeform out of the store in one pass over
+ * just the dying.
+ */
 void EvolEngine::KillStarvedLifeforms() {
-  for (auto & lf : arena_->Lifeforms()) {
-    if (lf->GetEnergy() <= 0.0) {
-      lf->SetKilled();
-      arena_->RemoveLifeform(lf);
-    }
+  const LifeformStore & lifeforms = arena_->Lifeforms();
+  Span<const float> energies = lifeforms.Energies();
+
+  // The starved, and those already dead of apoptosis
+  FindLifeforms([&](LifeformIndex lf) { return energies[lf] <= 0.0 || !lifeforms.Alive(lf); },
+                dying_);
+  for (LifeformIndex lf : dying_) {
+    arena_->KillLifeform(lf);
   }
+  arena_->ReapDeadLifeforms(dying_);
 }
 
 
+template <typename Policy>
 void EvolEngine::SplitFatLifeforms() {
-  auto lifeforms = arena_->Lifeforms();
-  for (auto & lf : lifeforms) {
-    if (!lf) {
-      abort();
-    }
-    float parent_energy = lf->GetEnergy();
-    if (parent_energy >= Params::kMeiosisLevel) {
-      Lifeform baby = lf->MakeChild();
-      baby->Mutate();
-      parent_energy -= Params::kMeiosisCost;
-      baby->SetEnergy(parent_energy / 2.0);
-      lf->SetEnergy(parent_energy / 2.0);
-      arena_->AddLifeform(baby, lf->GetCoord());
+  LifeformStore & lifeforms = arena_->Lifeforms();
+
+  // Newborns are appended to the store; don't split them until next turn.
+  // Births draw random numbers and intern genomes, so happen in order here.
+  Span<const float> energies = lifeforms.Energies();
+  FindLifeforms([&](LifeformIndex lf) { return energies[lf] >= Policy::MeiosisLevel(config_); },
+                splitting_);
+  for (LifeformIndex lf : splitting_) {
+    float parent_energy = lifeforms.GetEnergy(lf);
+    // The baby shares its parent's genome unless it mutates
+    GenomeRef baby_genome = lifeforms.GetGenome(lf);
+    const Dna * mutant = mutation_.Mutate(baby_genome->GetDna(), config_);
+    if (mutant != nullptr) {
+      baby_genome = arena_->Genomes().Intern(*mutant);
     }
+    parent_energy -= Policy::MeiosisCost(config_);
+    lifeforms.SetEnergy(lf, parent_energy / 2.0);
+    arena_->AddLifeform(lifeforms.Gen(lf) + 1, std::move(baby_genome), parent_energy / 2.0,
+                        lifeforms.GetCoord(lf));
   }
 }
 
@@ -15,35 +15,48 @@
 #include <atomic>
 #include <cstdint>
 #include <ctime>
-#include <forward_list>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <vector>
-#include <unordered_map>
 
 #include "Action.h"
 #include "Asteroid.h"
 #include "Arena.h"
+#include "Config.h"
+#include "Dna.h"
+#include "EnergyKernel.h"
+#include "Lifeform.h"
+#include "LifeformSnapshot.h"
+#include "Mutation.h"
 #include "Params.h"
+#include "PausePoint.h"
+#include "Random.h"
+#include "ThreadPool.h"
 #include "Timer.h"
 
 namespace evol {
 
 
-typedef std::unordered_map<Coord, std::vector<Action>> ActionMap;
+class CheckpointReader;
+class CheckpointWriter;
 
 
 class EvolEngine {
  public:
   EvolEngine()
-      : do_exit_(true), arena_(nullptr), turns_(0), asteroid_(nullptr) {}
+      : do_exit_(true), finished_(false), arena_(nullptr), run_turns_(nullptr),
+        policy_name_(nullptr), turns_(0), max_turns_(0), lifeform_updates_(0),
+        run_seconds_(0.0), index_(0), asteroid_(nullptr) {}
 
-  EvolEngine(int width, int height, Asteroid * asteroid = nullptr)
-      : do_exit_(false),
-        arena_(new Arena(width, height)),
-        turns_(0),
-        asteroid_(asteroid) {}
+  /**
+   * Engine number index of num_engines, running with the given settings.
+   * Engines issue lifeform ids from disjoint sequences, and each draws from
+   * its own random stream (seeded from the calling thread's until
+   * SetRandomSeed() says otherwise).
+   */
+  EvolEngine(const Config & config, Asteroid * asteroid = nullptr,
+             unsigned index = 0, unsigned num_engines = 1);
 
   EvolEngine & operator=(EvolEngine && other) {
     if (!do_exit_)
@@ -57,10 +70,19 @@ class EvolEngine {
     std::lock_guard<std::mutex> lgo(other.mutex_, std::adopt_lock);
 
     arena_ = std::move(other.arena_);
+    config_ = other.config_;
+    run_turns_ = other.run_turns_;
+    policy_name_ = other.policy_name_;
     turns_ = other.turns_;
+    max_turns_ = other.max_turns_;
+    lifeform_updates_ = other.lifeform_updates_;
+    index_ = other.index_;
+    rng_ = other.rng_;
     timers_.clear();  // these don't move; list is kept for export
     asteroid_ = other.asteroid_;
+    pause_ = other.pause_;
     other.turns_ = 0;
+    other.lifeform_updates_ = 0;
     other.timers_.clear();
     other.asteroid_ = nullptr;
 
@@ -77,16 +99,82 @@ class EvolEngine {
     do_exit_ = true;
   }
 
+  /**
+   * Reseed the engine's random stream.  Engines given the same seed (and
+   * config) play out identically.
+   */
+  void SetRandomSeed(uint64_t seed) {
+    rng_.Seed(seed);
+  }
+
   /**
    * Loads a given number of lifeforms into random coordinates on the arena.
    */
   void Seed(unsigned num_lifeforms);
 
   /**
-   * Begins simulation.  Will not exit until do_exit_ is set.
+   * Stop after the given number of turns; 0 means run until DoExit().
+   */
+  void SetMaxTurns(uint64_t max_turns) {
+    max_turns_ = max_turns;
+  }
+
+  /**
+   * Check in with the given PausePoint at the top of every turn, so the
+   * engine can be stopped for a checkpoint.
+   */
+  void SetPausePoint(PausePoint * pause) {
+    pause_ = pause;
+  }
+
+  /**
+   * Write the engine's state (turn count, random stream and arena) to a
+   * checkpoint.  The engine must be parked at its PausePoint, or not
+   * running.
+   */
+  void SaveCheckpoint(CheckpointWriter & out) const;
+
+  /**
+   * Load a newly made engine's state from a checkpoint, before Run().
+   * Returns false (after complaining on stderr) if the checkpoint is bad.
+   */
+  bool RestoreCheckpoint(CheckpointReader & in);
+
+  /**
+   * Begins simulation.  Will not exit until do_exit_ is set or the turn
+   * limit is reached.
    */
   void Run();
 
+  /**
+   * Return a description of the specialization the engine runs with; see
+   * EnginePolicy.h.
+   */
+  const char * PolicyName() const { return policy_name_; }
+
+  /**
+   * Return true once Run() has returned.
+   */
+  bool Finished() const { return finished_; }
+
+  /**
+   * Throughput counters: turns run, lifeform Dna evaluations over all those
+   * turns, and wall-clock time spent in Run() (only set once it returns).
+   * Hold Mutex() to read them while the engine is running.
+   */
+  uint64_t Turns() const { return turns_; }
+  uint64_t LifeformUpdates() const { return lifeform_updates_; }
+  double RunSeconds() const { return run_seconds_; }
+
+  /**
+   * Copy the arena's lifeforms into the given snapshot.  The engine is held
+   * up only for the copy.
+   */
+  void TakeSnapshot(LifeformSnapshot & snapshot) {
+    std::lock_guard<std::mutex> lg(mutex_);
+    snapshot.Take(arena_->Lifeforms());
+  }
+
   /**
    * Returns engine mutex (see explanation below).
    */
@@ -106,10 +194,28 @@ class EvolEngine {
   // Loop condition for Run().
   std::atomic<bool> do_exit_;
 
+  // Set when Run() returns
+  std::atomic<bool> finished_;
+
   std::unique_ptr<Arena> arena_;
 
-  // Number of turns since start of simulation
+  Config config_;
+
+  // The turn loop, as instantiated for the policy matching config_
+  void (EvolEngine::*run_turns_)(Timer &);
+  const char * policy_name_;
+
+  // Number of turns since start of simulation, and the limit (0 = none)
   uint64_t turns_;
+  uint64_t max_turns_;
+
+  // Throughput stats
+  uint64_t lifeform_updates_;
+  double run_seconds_;
+
+  // This engine's number, and its random stream
+  unsigned index_;
+  Xoshiro256 rng_;
 
   // List of timers currently in use by the program
   std::list<const Timer *> timers_;
@@ -124,32 +230,144 @@ class EvolEngine {
   // External Asteroid object (for moving lifeforms between engines).
   Asteroid * asteroid_;
 
+  // Where to stop between turns when asked to, if anywhere
+  PausePoint * pause_ = nullptr;
+
+  // Scratch buffers for action resolution.  They are only ever grown, so in
+  // steady state a turn doesn't allocate.
+  std::vector<Action> actions_;          // one per lifeform, by index
+  std::vector<uint32_t> action_cells_;   // destination square of each action
+  std::vector<uint32_t> cell_offsets_;   // start of each square's bucket
+  std::vector<Action> sorted_actions_;   // actions bucketed by destination
+  std::vector<Action> strip_actions_;    // the same, bucketed by source strip
+  std::vector<uint32_t> strip_offsets_;  // start of each strip's bucket
+  std::vector<uint32_t> dest_order_;     // action indices by destination strip
+  std::vector<uint32_t> dest_offsets_;   // end of each strip's bucket there
+  std::vector<ActionType> move_draws_;   // directions for this turn's random moves
+  std::vector<uint32_t> slice_moves_;    // first of each slice's move_draws_
+  // Per slice of actions_ then per strip, the actions from that slice
+  // leaving and landing in the strip; then their cursors in the buckets
+  std::vector<uint32_t> source_counts_;
+  std::vector<uint32_t> dest_counts_;
+
+  // Lifeforms found by FindLifeforms(), per slice, and those about to die
+  // or give birth
+  std::vector<std::vector<LifeformIndex>> slice_found_;
+  std::vector<LifeformIndex> dying_;
+  std::vector<LifeformIndex> splitting_;
+
+  // Scratch planes for energy distribution, same layout as the arena's
+  std::vector<float> energy_shares_;     // offered by each empty square
+  std::vector<float> energy_gains_;      // received by each occupant
+
+  // Energy distribution arithmetic, vectorized for this CPU
+  EnergyKernel energy_kernel_;
+
+  // Helper threads, while Run() is running
+  ThreadPool * workers_ = nullptr;
+
+  // The arena is cut into num_strips_ horizontal strips of whole rows for
+  // the phases of a turn which change it; strip s is rows
+  // [strip_rows_[s], strip_rows_[s + 1]).  row_strips_ maps back from row to
+  // strip.
+  unsigned num_strips_ = 1;
+  std::vector<Unit> strip_rows_;
+  std::vector<uint32_t> row_strips_;
+
+  // Lifeforms on their way to or from the asteroid
+  std::vector<Lifeform> migrants_;
+
+  // Makes newborns' mutated Dna, from its own batch of random draws
+  Mutation mutation_;
+
+  // Directions for FINAL_MOVE_RANDOM, drawn in bulk
+  RandomBatch<ActionType> random_moves_ {kActionMoveBegin, kActionMoveEnd};
+
+  /**
+   * Run turns until do_exit_ is set or the turn limit is reached.  This and
+   * the per-turn steps below are templates on an engine policy (see
+   * EnginePolicy.h) so its constants fold into the loops.
+   */
+  template <typename Policy>
+  void RunTurns(Timer & loop_timer);
+
+  // Picks the RunTurns() instantiation for a Config; see EvolEngine.cc
+  struct Dispatch;
+
+  /**
+   * Cut the arena into strips, a few per worker thread.
+   */
+  void SetUpStrips();
+
+  /**
+   * Call fn(strip, first_row, end_row) for every strip, spread over the
+   * worker threads.  Returns once all are done, so this is a barrier between
+   * phases of the turn: a phase may read anything the previous phase wrote
+   * into any strip, including the rows either side of its own.
+   */
+  template <typename Fn>
+  void ForEachStrip(Fn fn);
+
+  /**
+   * Call fn(slice, begin, end) for num_strips_ consecutive slices of [0, n),
+   * e.g. of the lifeform store, spread over the worker threads.  A barrier
+   * like ForEachStrip().
+   */
+  template <typename Fn>
+  void ForEachSlice(size_t n, Fn fn);
+
+  /**
+   * Set found to the indices of the lifeforms for which pred(lf) holds, in
+   * increasing order, testing them on the worker threads.
+   */
+  template <typename Pred>
+  void FindLifeforms(Pred pred, std::vector<LifeformIndex> & found);
+
+  /**
+   * Return the ActionType selected by the given lifeform's Dna for its current
+   * situation.  Only the sensors its Dna tests are gathered from the arena and
+   * used to index its DecisionTable.  Changes nothing, so it may run on many
+   * threads at once; MOVE_RANDOM is left to MapActions() to resolve.
+   */
+  ActionType RunDna(LifeformIndex) const;
+
   /**
-   * Post-Dna processing, this method will collate a list of Actions decided by
-   * the living lifeforms into a map of coord => [action1, action2, ...].  The
-   * map is heavyweight so we return it by pointer.
+   * Post-Dna processing, this method will collate the Actions in actions_ by
+   * destination square into sorted_actions_, using a counting sort over the
+   * squares' dense indices, and by the strip each actor starts out in into
+   * strip_actions_.  Actions which do nothing are dropped, and random moves
+   * are given a direction and charged for.  Slices of the actions are
+   * counted and scattered on the worker threads, then each strip sorts the
+   * actions landing in it.
    */
-  ActionMap MapActions(const std::forward_list<Action> &) const;
+  template <typename Policy>
+  void MapActions();
 
   /**
-   * Resolve lifeform actions as collated by MapActions.
+   * Resolve lifeform actions as collated by MapActions, one strip per thread:
+   * first every actor leaves its square, then every mover lands on its new
+   * one.  A move across a strip boundary is thus handed from one thread to
+   * the other by the barrier between the two phases.
    */
-  void ResolveInteractions(ActionMap &);
+  void ResolveInteractions();
 
   /**
    * Calculate the total energy available to lifeforms on the grid, and apply
-   * this to what's alive.
+   * this to what's alive.  Doesn't allocate in steady state.
    */
+  template <typename Policy>
   void ApplyEnergyLevelsToLifeforms();
 
   /**
-   * lifeforms with energy <= 0.0 are kill
+   * lifeforms with energy <= 0.0 are kill, and the dead leave the store
    */
   void KillStarvedLifeforms();
 
   /**
-   * lifeforms with energy >= Params::kMeiosisLevel form babby
+   * lifeforms with energy >= meiosis_level form babby; the store is searched
+   * for them on the worker threads, and they split in order
    */
+  template <typename Policy>
   void SplitFatLifeforms();
 };
 
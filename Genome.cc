@@ -0,0 +1,35 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "Genome.h"
+
+namespace evol {
+
+
+GenomeRef GenomePool::Intern(Span<const OpCode> dna) {
+  const uint64_t hash = HashDna(dna);
+  auto found = index_.find(DnaKey{hash, dna});
+  if (found != index_.end()) {
+    return GenomeRef(found->second);
+  }
+
+  // The key refers to the genome's own copy of the Dna, which never changes
+  Genome * genome = new Genome(this, hash, dna);
+  index_.emplace(DnaKey{hash, genome->GetDna()}, genome);
+  return GenomeRef(genome);
+}
+
+
+void GenomePool::Erase(Genome * genome) {
+  index_.erase(DnaKey{genome->Hash(), genome->GetDna()});
+  delete genome;
+}
+
+
+}  // namespace evol
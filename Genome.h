@@ -0,0 +1,187 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_GENOME_H_
+#define EVOL_GENOME_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "DecisionTable.h"
+#include "Dna.h"
+#include "Span.h"
+#include "Types.h"
+
+namespace evol {
+
+
+/**
+ * 64-bit FNV-1a hash of a Dna sequence.  Stable across runs and machines, so
+ * it can go in dumps.
+ */
+inline uint64_t HashDna(Span<const OpCode> dna) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (OpCode opcode : dna) {
+    hash = (hash ^ static_cast<OpcodeBasicType>(opcode)) * 0x100000001b3;
+  }
+  return hash;
+}
+
+
+/**
+ * Hash map key for looking genomes up by their Dna, hashed once.
+ */
+struct DnaKey {
+  uint64_t hash;
+  Span<const OpCode> dna;
+
+  bool operator==(const DnaKey & o) const {
+    return hash == o.hash && dna.size() == o.dna.size() &&
+        memcmp(dna.data(), o.dna.data(), dna.size() * sizeof(OpCode)) == 0;
+  }
+
+  struct Hash {
+    size_t operator()(const DnaKey & k) const { return k.hash; }
+  };
+};
+
+
+class GenomePool;
+
+
+/**
+ * A Dna sequence shared by every lifeform on an arena which carries it, along
+ * with what is worked out from it once rather than per lifeform: its hash and
+ * its compiled DecisionTable.  A genome never changes; a lifeform whose Dna
+ * mutates gets a different genome.
+ */
+class Genome {
+ public:
+  Genome(const Genome &) = delete;
+  Genome & operator=(const Genome &) = delete;
+
+  const Dna & GetDna() const { return dna_; }
+  size_t Size() const { return dna_.size(); }
+  uint64_t Hash() const { return hash_; }
+  const DecisionTable & Table() const { return table_; }
+
+ private:
+  friend class GenomePool;
+  friend class GenomeRef;
+
+  Genome(GenomePool * pool, uint64_t hash, Span<const OpCode> dna)
+      : dna_(dna.begin(), dna.end()), hash_(hash), table_(dna_), refs_(0), pool_(pool) {}
+
+  const Dna dna_;
+  const uint64_t hash_;
+  const DecisionTable table_;
+  uint32_t refs_;
+  GenomePool * const pool_;
+};
+
+
+/**
+ * Counted reference to a Genome.  The genome is freed (and forgotten by its
+ * pool) when the last reference goes.  Counting isn't atomic: a pool and the
+ * references to its genomes must only be copied or dropped by one thread at
+ * a time (an engine's), though any thread may read through them.
+ */
+class GenomeRef {
+ public:
+  GenomeRef() : genome_(nullptr) {}
+  GenomeRef(const GenomeRef & o) : genome_(o.genome_) { Acquire(); }
+  GenomeRef(GenomeRef && o) noexcept : genome_(o.genome_) { o.genome_ = nullptr; }
+  ~GenomeRef() { Release(); }
+
+  GenomeRef & operator=(const GenomeRef & o) {
+    GenomeRef copy(o);
+    std::swap(genome_, copy.genome_);
+    return *this;
+  }
+  GenomeRef & operator=(GenomeRef && o) noexcept {
+    std::swap(genome_, o.genome_);
+    return *this;
+  }
+
+  const Genome * get() const { return genome_; }
+  const Genome & operator*() const { return *genome_; }
+  const Genome * operator->() const { return genome_; }
+  explicit operator bool() const { return genome_ != nullptr; }
+
+ private:
+  friend class GenomePool;
+
+  explicit GenomeRef(Genome * genome) : genome_(genome) { Acquire(); }
+
+  void Acquire() {
+    if (genome_ != nullptr) {
+      ++genome_->refs_;
+    }
+  }
+  inline void Release();
+
+  Genome * genome_;
+};
+
+// Lets std::vector<GenomeRef> move, rather than copy (and count), on growth
+static_assert(std::is_nothrow_move_constructible<GenomeRef>::value &&
+              std::is_nothrow_move_assignable<GenomeRef>::value,
+              "GenomeRef moves must be noexcept");
+
+
+/**
+ * Interns genomes: there is at most one Genome per distinct Dna sequence, so
+ * clones share one copy of their Dna (and its DecisionTable), and memory
+ * grows with the population's diversity rather than its size.  Each Arena
+ * has one.
+ */
+class GenomePool {
+ public:
+  GenomePool() {}
+  ~GenomePool() { assert(index_.empty()); }
+
+  GenomePool(const GenomePool &) = delete;
+  GenomePool & operator=(const GenomePool &) = delete;
+
+  /**
+   * Return the genome for the given Dna, making it (and copying the Dna)
+   * only if there is none yet.
+   */
+  GenomeRef Intern(Span<const OpCode> dna);
+
+  /**
+   * Number of distinct genomes in use.
+   */
+  size_t Size() const { return index_.size(); }
+
+ private:
+  friend class GenomeRef;
+
+  // Called when the last reference to a genome is dropped
+  void Erase(Genome * genome);
+
+  std::unordered_map<DnaKey, Genome *, DnaKey::Hash> index_;
+};
+
+
+void GenomeRef::Release() {
+  if (genome_ != nullptr && --genome_->refs_ == 0) {
+    genome_->pool_->Erase(genome_);
+  }
+  genome_ = nullptr;
+}
+
+
+}  // namespace evol
+#endif  // EVOL_GENOME_H_
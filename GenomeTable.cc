@@ -0,0 +1,74 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "GenomeTable.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace evol {
+
+
+void GenomeTable::Build(const LifeformSnapshot & snapshot) {
+  Clear();
+  record_genomes_.resize(snapshot.Size());
+  for (size_t i = 0; i < snapshot.Size(); ++i) {
+    const LifeformSnapshot::Record & record = snapshot.Get(i);
+    Span<const OpCode> dna = snapshot.GetDna(i);
+    uint32_t id = Find(HashDna(dna), dna);
+    record_genomes_[i] = id;
+
+    Genome & g = genomes_[id];
+    ++g.count;
+    g.min_gen = std::min(g.min_gen, record.gen);
+    g.max_gen = std::max(g.max_gen, record.gen);
+    g.min_energy = std::min(g.min_energy, record.energy);
+    g.max_energy = std::max(g.max_energy, record.energy);
+    g.total_energy += record.energy;
+  }
+}
+
+
+void GenomeTable::Merge(const GenomeTable & other, std::vector<uint32_t> * remap) {
+  remap->resize(other.Size());
+  for (size_t i = 0; i < other.Size(); ++i) {
+    const Genome & o = other.genomes_[i];
+    uint32_t id = Find(o.hash, o.dna);
+    (*remap)[i] = id;
+
+    Genome & g = genomes_[id];
+    g.count += o.count;
+    g.min_gen = std::min(g.min_gen, o.min_gen);
+    g.max_gen = std::max(g.max_gen, o.max_gen);
+    g.min_energy = std::min(g.min_energy, o.min_energy);
+    g.max_energy = std::max(g.max_energy, o.max_energy);
+    g.total_energy += o.total_energy;
+  }
+}
+
+
+void GenomeTable::Clear() {
+  genomes_.clear();
+  index_.clear();
+  record_genomes_.clear();
+}
+
+
+uint32_t GenomeTable::Find(uint64_t hash, Span<const OpCode> dna) {
+  auto inserted = index_.emplace(DnaKey{hash, dna}, genomes_.size());
+  if (inserted.second) {
+    genomes_.push_back(Genome{hash, dna, 0, std::numeric_limits<uint64_t>::max(), 0,
+                              std::numeric_limits<float>::infinity(),
+                              -std::numeric_limits<float>::infinity(), 0.0});
+  }
+  return inserted.first->second;
+}
+
+
+}  // namespace evol
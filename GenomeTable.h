@@ -0,0 +1,92 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_GENOME_TABLE_H_
+#define EVOL_GENOME_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Genome.h"
+#include "LifeformSnapshot.h"
+#include "Span.h"
+#include "Types.h"
+
+namespace evol {
+
+
+/**
+ * The distinct genomes (Dna sequences) among some lifeforms, with how many
+ * lifeforms carry each and their spread of generations and energies.  A
+ * mature population is mostly clones, so this is typically a small fraction
+ * of the size of the population.
+ *
+ * A table is built from one snapshot, which is independent of any other, so
+ * engines' tables can be built in parallel; they are then merged into one
+ * for the whole simulation.  Genomes are numbered in order of first
+ * appearance.  Tables refer to their snapshots' Dna rather than copying it,
+ * so must not outlive them (or a retake of them).
+ */
+class GenomeTable {
+ public:
+  struct Genome {
+    uint64_t hash;
+    Span<const OpCode> dna;
+    uint64_t count;
+    uint64_t min_gen;
+    uint64_t max_gen;
+    float min_energy;
+    float max_energy;
+    double total_energy;
+  };
+
+  GenomeTable() {}
+
+  GenomeTable(const GenomeTable &) = delete;
+  GenomeTable & operator=(const GenomeTable &) = delete;
+
+  /**
+   * Replace the contents with the genomes of the given snapshot's lifeforms.
+   * Afterwards RecordGenome(i) is the genome of the snapshot's record i.
+   */
+  void Build(const LifeformSnapshot & snapshot);
+
+  /**
+   * Add other's genomes to this table, combining their stats with any
+   * already here.  remap is set to the id here of each of other's genomes.
+   */
+  void Merge(const GenomeTable & other, std::vector<uint32_t> * remap);
+
+  void Clear();
+
+  size_t Size() const { return genomes_.size(); }
+  const Genome & Get(size_t i) const { return genomes_[i]; }
+
+  /**
+   * The genome of each record of the snapshot last given to Build().
+   */
+  uint32_t RecordGenome(size_t record) const { return record_genomes_[record]; }
+
+ private:
+  /**
+   * Return the id of the genome with the given Dna, adding it (with no
+   * lifeforms yet) if it's new.
+   */
+  uint32_t Find(uint64_t hash, Span<const OpCode> dna);
+
+  std::vector<Genome> genomes_;
+  std::unordered_map<DnaKey, uint32_t, DnaKey::Hash> index_;
+  std::vector<uint32_t> record_genomes_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_GENOME_TABLE_H_
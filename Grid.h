@@ -10,6 +10,8 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <vector>
 
 #include "Coord.h"
 
@@ -48,6 +50,16 @@ class Grid {
     spaces_.resize(xMax_ * yMax_);
   }
 
+  /**
+   * As above, but every space is a copy of fill.
+   */
+  Grid(const Unit xMax, const Unit yMax, const T & fill) {
+    assert(xMax > 0 && yMax > 0);
+    xMax_ = xMax;
+    yMax_ = yMax;
+    spaces_.resize(xMax_ * yMax_, fill);
+  }
+
   /**
    * Return reference to contained object at the given coords.
    */
@@ -63,6 +75,34 @@ class Grid {
   Unit XMax() const { return xMax_; }
   Unit YMax() const { return yMax_; }
 
+  /**
+   * Return the number of spaces in the grid.
+   */
+  size_t Size() const { return spaces_.size(); }
+
+  /**
+   * Return pointer to the spaces in row-major order, for passes over the whole
+   * grid.
+   */
+  T * Data() { return spaces_.data(); }
+  const T * Data() const { return spaces_.data(); }
+
+  /**
+   * Return the row-major index of the given coords; the inverse of CoordOf().
+   */
+  size_t IndexOf(const Coord & c) const {
+    assert(c.y >= 0 && c.y < yMax_ && c.x >= 0 && c.x < xMax_);
+    return c.y * xMax_ + c.x;
+  }
+
+  /**
+   * Return the coords of the given row-major index.
+   */
+  Coord CoordOf(size_t i) const {
+    assert(i < spaces_.size());
+    return Coord(i % xMax_, i / xMax_);
+  }
+
   /**
    * Normalize the given coordinate to a point wrapped within the grid.
    */
@@ -10,31 +10,26 @@
 #ifndef EVOL_LIFEFORM_H_
 #define EVOL_LIFEFORM_H_
 
-#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "Coord.h"
+#include "Dna.h"
 #include "Types.h"
 
 namespace evol {
 
 
-typedef std::vector<OpCode> Dna;
-
 class LifeformImpl;
 
 typedef std::shared_ptr<LifeformImpl> Lifeform;
 
 /**
- * Convenience function returns a new lifeform.
+ * A single lifeform detached from any Arena, e.g. while it rides the Asteroid
+ * between engines.  Lifeforms living on an Arena are kept in its
+ * LifeformStore instead.
  */
-inline Lifeform make_lifeform(uint64_t gen = 0, Dna dna = Dna{}) {
-  return std::make_shared<LifeformImpl>(gen, dna);
-}
-
-
 class LifeformImpl {
  public:
   LifeformImpl() {}
@@ -51,13 +46,17 @@ class LifeformImpl {
     o.id_ = 0;
   }
 
-  LifeformImpl(uint64_t gen, const Dna & dna)
-      : gen_(gen),
-        alive_(true),
-        energy_(1.0),
-        dna_(dna) {
-    id_ = ++LifeformImpl::next_id_;
-  }
+  /**
+   * Construct a copy of an existing lifeform's record.
+   */
+  LifeformImpl(uint64_t id, uint64_t gen, bool alive, float energy, const Coord & c,
+               const Dna & dna)
+      : id_(id),
+        gen_(gen),
+        alive_(alive),
+        energy_(energy),
+        coord_(c),
+        dna_(dna) {}
 
   LifeformImpl & operator=(const LifeformImpl & o) {
     id_ = o.id_;
@@ -77,33 +76,9 @@ class LifeformImpl {
   void SetKilled() { alive_ = false; }
 
   /**
-   * Return a new lifeform with Dna equal to the current instance.
-   */
-  Lifeform MakeChild() const {
-    return std::make_shared<LifeformImpl>(gen_ + 1, dna_);
-  }
-
-  /**
-   * Mutate the Dna of the current lifeform by inserting, deleting, changing, or
-   * translating one or more opcodes.
+   * Return reference to the organism's Dna code.
    */
-  void Mutate();
-
-  /**
-   * Return the ActionType selected by the lifeform's Dna code for its current
-   * situation.  This is the method that actually executes the Dna.  Its
-   * only argument is a pointer to the Arena.
-   *
-   * TODO: This is a void * because we can't include Arena.h due to circular
-   * deps.  We should fix this.  Might be sane to move DNA processing to its
-   * own class, some kind of lifeform VM maybe.
-   */
-  ActionType RunDna(void *);
-
-  /**
-   * Return copy of the organism's Dna code.
-   */
-  Dna GetDna() const { return dna_; }
+  const Dna & GetDna() const { return dna_; }
 
   /**
    * Return size of the organism's Dna code.
@@ -117,7 +92,7 @@ class LifeformImpl {
     return coord_;
   }
 
-  void SetEnergy(int32_t new_e) {
+  void SetEnergy(float new_e) {
     energy_ = new_e;
   }
   float GetEnergy() const {
@@ -132,14 +107,6 @@ class LifeformImpl {
   }
 
  private:
-  // See Lifeform.cc for explanations
-  void MutateInsert(int32_t, int32_t);
-  void MutateDelete(int32_t, int32_t);
-  void MutateChange(int32_t, int32_t);
-  void MutateTranslate(int32_t, int32_t);
-
-  static std::atomic<uint64_t> next_id_;
-
   uint64_t id_;
   uint64_t gen_;
   bool alive_;
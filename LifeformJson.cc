@@ -0,0 +1,123 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "LifeformJson.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "BufferedWriter.h"
+#include "Types.h"
+
+namespace evol {
+
+
+namespace {
+
+void WriteDna(Span<const OpCode> dna, BufferedWriter & out) {
+  const char *separator = "\"";
+  out.Put("[");
+  for (OpCode opcode : dna) {
+    out.Put(separator);
+    out.Put(OpcodeName(opcode));
+    out.Put("\"", 1);
+    separator = ", \"";
+  }
+  out.Put("]");
+}
+
+
+void WriteLifeforms(const std::vector<LifeformSnapshot> & snapshots, BufferedWriter & out) {
+  bool first = true;
+  out.Put("[\n");
+  for (auto & snapshot : snapshots) {
+    for (size_t lf = 0; lf < snapshot.Size(); ++lf) {
+      const LifeformSnapshot::Record & record = snapshot.Get(lf);
+      out.Put(first ? "  {\"id\": " : ",\n  {\"id\": ");
+      first = false;
+      out.Put(record.id);
+      out.Put(", \"gen\": ");
+      out.Put(record.gen);
+      out.Put(record.alive ? ", \"alive\": true, \"energy\": " : ", \"alive\": false, \"energy\": ");
+      out.Put(record.energy);
+      out.Put(", \"dna\": ");
+      WriteDna(snapshot.GetDna(lf), out);
+      out.Put("}");
+    }
+  }
+  out.Put(first ? "]\n" : "\n]\n");
+}
+
+
+void WriteGenomes(const std::vector<LifeformSnapshot> & snapshots,
+                  const std::vector<GenomeTable> & tables, const GenomeTable & genomes,
+                  const std::vector<std::vector<uint32_t>> & remaps, BufferedWriter & out) {
+  out.Put("{\"genomes\": [");
+  for (size_t id = 0; id < genomes.Size(); ++id) {
+    const GenomeTable::Genome & g = genomes.Get(id);
+    out.Put(id == 0 ? "\n  {\"genome\": " : ",\n  {\"genome\": ");
+    out.Put(uint64_t(id));
+    char hash[32];
+    out.Put(hash, snprintf(hash, sizeof(hash), ", \"hash\": \"%016" PRIx64 "\"", g.hash));
+    out.Put(", \"count\": ");
+    out.Put(g.count);
+    out.Put(", \"min_gen\": ");
+    out.Put(g.min_gen);
+    out.Put(", \"max_gen\": ");
+    out.Put(g.max_gen);
+    out.Put(", \"min_energy\": ");
+    out.Put(g.min_energy);
+    out.Put(", \"max_energy\": ");
+    out.Put(g.max_energy);
+    out.Put(", \"mean_energy\": ");
+    out.Put(float(g.total_energy / g.count));
+    out.Put(", \"dna\": ");
+    WriteDna(g.dna, out);
+    out.Put("}");
+  }
+
+  bool first = true;
+  out.Put("],\n \"lifeforms\": [");
+  for (size_t i = 0; i < snapshots.size(); ++i) {
+    for (size_t lf = 0; lf < snapshots[i].Size(); ++lf) {
+      const LifeformSnapshot::Record & record = snapshots[i].Get(lf);
+      out.Put(first ? "\n  {\"id\": " : ",\n  {\"id\": ");
+      first = false;
+      out.Put(record.id);
+      out.Put(", \"gen\": ");
+      out.Put(record.gen);
+      out.Put(record.alive ? ", \"alive\": true, \"energy\": " : ", \"alive\": false, \"energy\": ");
+      out.Put(record.energy);
+      out.Put(", \"genome\": ");
+      out.Put(uint64_t(remaps[i][tables[i].RecordGenome(lf)]));
+      out.Put("}");
+    }
+  }
+  out.Put("]}\n");
+}
+
+}  // namespace anon
+
+
+bool WriteLifeformsJson(const std::vector<LifeformSnapshot> & snapshots, const std::string & filename) {
+  return WriteFileAtomically(filename, [&](BufferedWriter & out) { WriteLifeforms(snapshots, out); });
+}
+
+
+bool WriteGenomesJson(const std::vector<LifeformSnapshot> & snapshots,
+                      const std::vector<GenomeTable> & tables, const GenomeTable & genomes,
+                      const std::vector<std::vector<uint32_t>> & remaps,
+                      const std::string & filename) {
+  return WriteFileAtomically(filename, [&](BufferedWriter & out) {
+    WriteGenomes(snapshots, tables, genomes, remaps, out);
+  });
+}
+
+
+}  // namespace evol
@@ -10,58 +10,49 @@
 #ifndef EVOL_LIFEFORM_JSON_H_
 #define EVOL_LIFEFORM_JSON_H_
 
-#include <json-c/json.h>
-#include <unistd.h>
-
-#include <memory>
 #include <string>
-#include <utility>
-
-namespace evol {
+#include <vector>
 
+#include "GenomeTable.h"
+#include "LifeformSnapshot.h"
 
-class JsonDeleter {
- public:
-  void operator()(json_object *p) {
-    // Decrement json-c library reference count
-    json_object_put(p);
-  }
-};
+namespace evol {
 
 
 /**
- * Serializes iterators to the given container of Lifeform pointers into JSON.
- * Returns a unique_ptr to the json_object array.
+ * Write every lifeform in the given snapshots to a file as one JSON array of
+ * objects:
+ *
+ *   {"id": 12, "gen": 3, "alive": true, "energy": 1.5, "dna": ["NOP", ...]}
+ *
+ * The text is streamed straight into a buffer as it is generated, so memory
+ * use doesn't grow with the number of lifeforms.  It goes to a temporary file
+ * which is renamed over filename once complete, so readers never see half a
+ * dump.  Returns false (after complaining on stderr) if the file couldn't be
+ * written, in which case any previous dump is left alone.
  */
-template<typename Iter>
-std::unique_ptr<json_object, JsonDeleter> JsonifyLifeforms(const Iter & begin_it, const Iter &end_it) {
-  std::unique_ptr<json_object, JsonDeleter> json_lifeform_array (json_object_new_array(), JsonDeleter());
+bool WriteLifeformsJson(const std::vector<LifeformSnapshot> & snapshots, const std::string & filename);
 
-  for (auto it = begin_it; it != end_it; it++) {
-    const Lifeform lf = *it;
-    struct json_object *json_lifeform = json_object_new_object();
-    json_object_object_add(json_lifeform, "id", json_object_new_int64(lf->Id()));
-    json_object_object_add(json_lifeform, "gen", json_object_new_int64(lf->Gen()));
-    json_object_object_add(json_lifeform, "alive", json_object_new_boolean(lf->Alive()));
-    json_object_object_add(json_lifeform, "energy", json_object_new_double(lf->GetEnergy()));
 
-    json_object *dna = json_object_new_array();
-    for (auto & opcode : lf->GetDna()) {
-      std::string opcode_name;
-      auto iter = kOpcodeStrings.find(opcode);
-      if (iter != kOpcodeStrings.end()) {
-        opcode_name = iter->second;
-      } else {
-        opcode_name = "?UNKNOWN?";
-      }
-      json_object_array_add(dna, json_object_new_string(opcode_name.c_str()));
-    }
-    json_object_object_add(json_lifeform, "dna", dna);
-    json_object_array_add(json_lifeform_array.get(), json_lifeform);
-  }
-
-  return json_lifeform_array;
-}
+/**
+ * Write the given snapshots as above, but with each distinct Dna written only
+ * once, in a table of genomes which the lifeforms refer to:
+ *
+ *   {"genomes": [
+ *     {"genome": 0, "hash": "8a1f...", "count": 420, "min_gen": 3, "max_gen": 9,
+ *      "min_energy": 0.5, "max_energy": 7, "mean_energy": 2.25, "dna": [...]},
+ *     ...],
+ *    "lifeforms": [
+ *     {"id": 12, "gen": 3, "alive": true, "energy": 1.5, "genome": 0},
+ *     ...]}
+ *
+ * tables[i] must have been built from snapshots[i] and merged into genomes,
+ * giving remaps[i].
+ */
+bool WriteGenomesJson(const std::vector<LifeformSnapshot> & snapshots,
+                      const std::vector<GenomeTable> & tables, const GenomeTable & genomes,
+                      const std::vector<std::vector<uint32_t>> & remaps,
+                      const std::string & filename);
 
 
 }  // namespace evol
@@ -0,0 +1,91 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_LIFEFORM_SNAPSHOT_H_
+#define EVOL_LIFEFORM_SNAPSHOT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "LifeformStore.h"
+#include "Span.h"
+#include "Types.h"
+
+namespace evol {
+
+
+/**
+ * A copy of what the Dumper writes out about each lifeform on an arena, so
+ * it can be written without holding up the engine.  Taking one is just a
+ * sweep over the store's columns into two flat arrays: a fixed-size record
+ * per lifeform, and all their Dna end to end.  A snapshot which is retaken
+ * reuses its arrays, so in steady state it doesn't allocate.
+ */
+class LifeformSnapshot {
+ public:
+  struct Record {
+    uint64_t id;
+    uint64_t gen;
+    float energy;
+    bool alive;
+    uint32_t dna_size;
+    size_t dna_begin;   // offset into the shared Dna array
+  };
+
+  /**
+   * Replace the contents with a copy of the given store.
+   */
+  void Take(const LifeformStore & lifeforms) {
+    records_.resize(lifeforms.Size());
+    dna_.clear();
+    for (LifeformIndex lf = 0; lf < lifeforms.Size(); ++lf) {
+      const Dna & dna = lifeforms.GetDna(lf);
+      records_[lf] = Record{lifeforms.Id(lf), lifeforms.Gen(lf), lifeforms.GetEnergy(lf),
+                            lifeforms.Alive(lf), uint32_t(dna.size()), dna_.size()};
+      dna_.insert(dna_.end(), dna.begin(), dna.end());
+    }
+  }
+
+  /**
+   * Append a lifeform with the given Dna; record's dna_begin and dna_size
+   * are filled in.
+   */
+  void Add(Record record, Span<const OpCode> dna) {
+    record.dna_size = dna.size();
+    record.dna_begin = dna_.size();
+    records_.push_back(record);
+    dna_.insert(dna_.end(), dna.begin(), dna.end());
+  }
+
+  void Clear() {
+    records_.clear();
+    dna_.clear();
+  }
+
+  size_t Size() const { return records_.size(); }
+  const Record & Get(size_t i) const { return records_[i]; }
+
+  Span<const OpCode> GetDna(size_t i) const {
+    return Span<const OpCode>(dna_.data() + records_[i].dna_begin, records_[i].dna_size);
+  }
+
+  /**
+   * Every lifeform's Dna end to end; Record::dna_begin is an offset into
+   * this.
+   */
+  Span<const OpCode> AllDna() const { return dna_; }
+
+ private:
+  std::vector<Record> records_;
+  std::vector<OpCode> dna_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_LIFEFORM_SNAPSHOT_H_
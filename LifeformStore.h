@@ -0,0 +1,170 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_LIFEFORM_STORE_H_
+#define EVOL_LIFEFORM_STORE_H_
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Coord.h"
+#include "DecisionTable.h"
+#include "Genome.h"
+#include "Lifeform.h"
+#include "Span.h"
+#include "Types.h"
+
+namespace evol {
+
+
+// Index of a lifeform's record in a LifeformStore.  Indices are stable until
+// the store is compacted.
+typedef uint32_t LifeformIndex;
+
+
+/**
+ * Structure-of-arrays storage for all lifeforms on an Arena.  Each attribute
+ * lives in its own contiguous column, so passes which only care about one or
+ * two attributes (energy, say) sweep straight through memory instead of
+ * chasing a pointer per lifeform.
+ *
+ * Records are removed in constant time by moving the last record into the
+ * vacated slot (swap-and-pop).  Since that renumbers the last record, engines
+ * mark lifeforms dead while iterating and remove them afterwards (see
+ * Arena::ReapDeadLifeforms()).
+ *
+ * Each record also carries the index of its entry in its ArenaBlock's
+ * occupant list, so that list can be updated in constant time as well.
+ *
+ * Dna isn't stored per lifeform: each record holds a reference to an interned
+ * Genome, shared with its clones, from the Arena's GenomePool.
+ */
+class LifeformStore {
+ public:
+  LifeformStore() {}
+
+  LifeformStore(const LifeformStore &) = delete;
+  LifeformStore & operator=(const LifeformStore &) = delete;
+
+  /**
+   * Return number of records, including dead ones not yet compacted.
+   */
+  LifeformIndex Size() const { return ids_.size(); }
+  bool Empty() const { return ids_.empty(); }
+
+  /**
+   * Append a living lifeform.  Returns its index.
+   */
+  LifeformIndex Add(uint64_t id, uint64_t gen, float energy, const Coord & c, uint32_t cell,
+                    GenomeRef genome) {
+    ids_.push_back(id);
+    gens_.push_back(gen);
+    energies_.push_back(energy);
+    coords_.push_back(c);
+    cells_.push_back(cell);
+    dna_sizes_.push_back(genome->Size());
+    alive_.push_back(true);
+    block_slots_.push_back(0);
+    genomes_.push_back(std::move(genome));
+    return ids_.size() - 1;
+  }
+
+  /**
+   * Return a detached copy of the given record.
+   */
+  Lifeform Get(LifeformIndex i) const {
+    return std::make_shared<LifeformImpl>(ids_[i], gens_[i], alive_[i], energies_[i],
+                                          coords_[i], genomes_[i]->GetDna());
+  }
+
+  uint64_t Id(LifeformIndex i) const { return ids_[i]; }
+  uint64_t Gen(LifeformIndex i) const { return gens_[i]; }
+
+  bool Alive(LifeformIndex i) const { return alive_[i]; }
+  void SetKilled(LifeformIndex i) { alive_[i] = false; }
+
+  float GetEnergy(LifeformIndex i) const { return energies_[i]; }
+  void SetEnergy(LifeformIndex i, float e) { energies_[i] = e; }
+
+  Coord GetCoord(LifeformIndex i) const { return coords_[i]; }
+  uint32_t GetCell(LifeformIndex i) const { return cells_[i]; }
+  void SetCoord(LifeformIndex i, const Coord & c, uint32_t cell) {
+    coords_[i] = c;
+    cells_[i] = cell;
+  }
+
+  uint32_t BlockSlot(LifeformIndex i) const { return block_slots_[i]; }
+  void SetBlockSlot(LifeformIndex i, uint32_t slot) { block_slots_[i] = slot; }
+
+  const GenomeRef & GetGenome(LifeformIndex i) const { return genomes_[i]; }
+  const Dna & GetDna(LifeformIndex i) const { return genomes_[i]->GetDna(); }
+  size_t GetDnaSize(LifeformIndex i) const { return dna_sizes_[i]; }
+
+  const DecisionTable & GetTable(LifeformIndex i) const { return genomes_[i]->Table(); }
+
+  /**
+   * Views of whole columns, for passes which sweep every lifeform.  These are
+   * invalidated by Add() and SwapRemove().
+   */
+  Span<const uint64_t> Ids() const { return ids_; }
+  Span<const uint64_t> Gens() const { return gens_; }
+  Span<float> Energies() { return energies_; }
+  Span<const float> Energies() const { return energies_; }
+  Span<const Coord> Coords() const { return coords_; }
+  Span<const uint32_t> Cells() const { return cells_; }
+  Span<const uint32_t> DnaSizes() const { return dna_sizes_; }
+
+  /**
+   * Remove the given record by moving the last record into its slot.  Returns
+   * true if a record was moved, in which case it is now at index i.
+   */
+  bool SwapRemove(LifeformIndex i) {
+    assert(i < Size());
+    LifeformIndex last = Size() - 1;
+    bool moved = i != last;
+    if (moved) {
+      ids_[i] = ids_[last];
+      gens_[i] = gens_[last];
+      energies_[i] = energies_[last];
+      coords_[i] = coords_[last];
+      cells_[i] = cells_[last];
+      alive_[i] = alive_[last];
+      block_slots_[i] = block_slots_[last];
+      genomes_[i] = std::move(genomes_[last]);
+      dna_sizes_[i] = dna_sizes_[last];
+    }
+    ids_.pop_back();
+    gens_.pop_back();
+    energies_.pop_back();
+    coords_.pop_back();
+    cells_.pop_back();
+    alive_.pop_back();
+    block_slots_.pop_back();
+    genomes_.pop_back();
+    dna_sizes_.pop_back();
+    return moved;
+  }
+
+ private:
+  std::vector<uint64_t> ids_;
+  std::vector<uint64_t> gens_;
+  std::vector<float> energies_;
+  std::vector<Coord> coords_;
+  std::vector<uint32_t> cells_;  // Row-major index of coords_, see Grid::IndexOf()
+  std::vector<uint8_t> alive_;
+  std::vector<uint32_t> block_slots_;
+  std::vector<GenomeRef> genomes_;
+  std::vector<uint32_t> dna_sizes_;  // Copied out of genomes_ for ApplyGains
+};
+
+
+}  // namespace evol
+#endif  // EVOL_LIFEFORM_STORE_H_
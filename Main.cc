@@ -7,8 +7,16 @@
  * License Version 3.  See file `COPYING' for details.
  */
 
+#include <getopt.h>
 #include <unistd.h>
+#include <cinttypes>
+#include <csignal>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
 #include <vector>
 #include <thread>
 
@@ -19,82 +27,337 @@
 #endif
 
 #include "Asteroid.h"
+#include "Checkpoint.h"
+#include "Checkpointer.h"
+#include "Config.h"
 #include "EvolEngine.h"
 #include "Dumper.h"
-#include "Params.h"
+#include "PausePoint.h"
+#include "Random.h"
 
 using namespace evol;
 
 
-int main(int argc, char *argv[]) {
+static void Usage(const char *argv0) {
+  fprintf(stderr,
+          "Usage: %s [--config FILE] [--set KEY=VALUE]... [--print-config]\n"
+          "          [--seed N | --resume FILE] [--headless] [--turns N] [--seconds T]\n"
+          "\n"
+          "  --config FILE    Load settings from FILE (KEY = VALUE lines)\n"
+          "  --set KEY=VALUE  Override one setting; later settings win\n"
+          "  --print-config   Print the resulting settings and exit\n"
+          "  --seed N      Deterministic run: derive every engine's random stream from\n"
+          "                N and exchange asteroid lifeforms in lockstep\n"
+          "  --resume FILE Carry on from a checkpoint (see checkpoint_filename), with\n"
+          "                its settings; --config and --set apply on top\n"
+          "  --headless    Run without a renderer (always the case if built without\n"
+          "                one); on exit, dump lifeforms and print throughput\n"
+          "  --turns N     Stop each engine after N turns (counting from the start of\n"
+          "                the run a checkpoint is from)\n"
+          "  --seconds T   Headless: stop after T seconds\n",
+          argv0);
+}
+
+
+// Set by SIGINT/SIGTERM to end a run early, headless or not
+static volatile sig_atomic_t got_exit_signal = 0;
+
+static void HandleExitSignal(int) {
+  got_exit_signal = 1;
+}
+
+
+/**
+ * Wait until every engine reaches its turn limit, the time limit (if any) is
+ * up, or we're signalled to exit.
+ */
+static void WaitForHeadlessRun(const std::vector<EvolEngine> & engines, double seconds) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+
+  while (!got_exit_signal) {
+    if (seconds > 0 && std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    bool all_finished = true;
+    for (auto & engine : engines) {
+      all_finished = all_finished && engine.Finished();
+    }
+    if (all_finished) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+}
+
+
+/**
+ * Print turns/sec and lifeform updates/sec for each (finished) engine.
+ */
+static void PrintThroughput(const std::vector<EvolEngine> & engines) {
+  double total_turns = 0.0, total_updates = 0.0;
+
+  for (unsigned i = 0; i < engines.size(); ++i) {
+    const EvolEngine & engine = engines[i];
+    double secs = engine.RunSeconds() > 0.0 ? engine.RunSeconds() : 1e-9;
+    double turns = engine.Turns() / secs;
+    double updates = engine.LifeformUpdates() / secs;
+    printf("Engine %u (%s): %" PRIu64 " turns in %.2f s, %.1f turns/sec, "
+           "%.0f lifeform updates/sec, %" PRIu64 " lifeforms\n",
+           i, engine.PolicyName(), engine.Turns(), engine.RunSeconds(), turns, updates,
+           engine.GetArena().NumLifeforms());
+    total_turns += turns;
+    total_updates += updates;
+  }
+  printf("Total: %.1f turns/sec, %.0f lifeform updates/sec\n", total_turns, total_updates);
+}
+
 
+/**
+ * Print the traffic over each edge of the migration graph.
+ */
+static void PrintMigration(const Asteroid & asteroid) {
+  for (size_t i = 0; i < asteroid.NumEdges(); ++i) {
+    const Asteroid::Edge & edge = asteroid.GetEdge(i);
+    printf("Migration %u -> %u: %" PRIu64 " launched, %" PRIu64 " landed, %" PRIu64 " evicted, "
+           "%" PRIu64 " turned away, %zu waiting\n",
+           edge.from, edge.to, edge.launched.load(), edge.landed.load(), edge.evicted.load(),
+           edge.turned_away.load(), edge.lifeforms.SizeApprox());
+  }
+}
+
+
+/**
+ * Tell every engine to stop.  With a checkpointer, they are first paused on
+ * a common turn for a last checkpoint, which is where they stop.
+ */
+static void StopEngines(std::vector<EvolEngine> & engines, Asteroid & asteroid,
+                        Checkpointer * checkpointer, PausePoint & pause) {
+  if (checkpointer != nullptr) {
+    checkpointer->DoExit();
+    checkpointer->JoinThread();
+    checkpointer->PauseAndCheckpoint();
+  }
+  for (auto & engine : engines) {
+    engine.DoExit();
+  }
+  pause.Resume();
+  asteroid.Cancel();
+}
+
+
+int main(int argc, char *argv[]) {
+  bool deterministic = false;
+  uint64_t seed = 0;
 #if EVOL_RENDERER_CURSES || EVOL_RENDERER_SFML
-  unsigned numCores = Params::kNumEngines;
-  if (numCores < 1) {
+  bool headless = false;
+#else
+  bool headless = true;
+#endif
+  uint64_t max_turns = 0;
+  double max_seconds = 0.0;
+  bool print_config = false;
+  const char *resume_filename = nullptr;
+  Config config;
+
+  // --config and --set, in order; applied once we know whether the settings
+  // start from the defaults or a checkpoint's
+  std::vector<std::pair<int, std::string>> settings;
+
+  static const struct option long_options[] = {
+    {"config", required_argument, nullptr, 'c'},
+    {"set", required_argument, nullptr, 'D'},
+    {"print-config", no_argument, nullptr, 'p'},
+    {"seed", required_argument, nullptr, 's'},
+    {"resume", required_argument, nullptr, 'r'},
+    {"headless", no_argument, nullptr, 'H'},
+    {"turns", required_argument, nullptr, 'n'},
+    {"seconds", required_argument, nullptr, 't'},
+    {"help", no_argument, nullptr, 'h'},
+    {nullptr, 0, nullptr, 0}
+  };
+  int opt;
+  while ((opt = getopt_long(argc, argv, "c:D:ps:r:Hn:t:h", long_options, nullptr)) != -1) {
+    char *end = nullptr;
+    switch (opt) {
+      case 'c':
+      case 'D':
+        settings.emplace_back(opt, optarg);
+        break;
+      case 'p':
+        print_config = true;
+        break;
+      case 's':
+        seed = strtoull(optarg, &end, 0);
+        deterministic = true;
+        break;
+      case 'r':
+        resume_filename = optarg;
+        break;
+      case 'H':
+        headless = true;
+        break;
+      case 'n':
+        max_turns = strtoull(optarg, &end, 0);
+        break;
+      case 't':
+        max_seconds = strtod(optarg, &end);
+        break;
+      case 'h':
+        Usage(argv[0]);
+        return 0;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+    if (end != nullptr && (*optarg == '\0' || *end != '\0')) {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (deterministic && resume_filename != nullptr) {
+    fprintf(stderr, "--seed and --resume can't be used together; a checkpoint of a seeded "
+            "run carries on deterministically\n");
+    return 1;
+  }
+
+  CheckpointReader checkpoint;
+  if (resume_filename != nullptr) {
+    std::string checkpoint_settings;
+    if (!checkpoint.Open(resume_filename) || !checkpoint.GetString(&checkpoint_settings) ||
+        !config.LoadString(checkpoint_settings, resume_filename)) {
+      return 1;
+    }
+    deterministic = checkpoint.Header().flags & CheckpointHeader::LOCKSTEP;
+  }
+  for (auto & setting : settings) {
+    if (setting.first == 'c' ? !config.Load(setting.second.c_str()) : !config.Set(setting.second))
+      return 1;
+  }
+  if (!config.Validate()) {
+    return 1;
+  }
+  if (print_config) {
+    config.Print(stdout);
+    return 0;
+  }
+
+  unsigned numCores = config.num_engines;
+  if (resume_filename != nullptr) {
+    numCores = checkpoint.Header().num_engines;
+  } else if (numCores < 1) {
     numCores = std::thread::hardware_concurrency();
     if (numCores < 1) {
       // Library detection failed
       numCores = 1;
     }
   }
-#else
-  unsigned numCores = 1;
-#endif
 
   std::vector<EvolEngine> engines(numCores);
   std::vector<std::thread> engine_threads(numCores);
-  Asteroid asteroid(Params::kAsteroidSize);
+  // Engine i draws from stream i of the seed, and the migration graph from
+  // the one after the last engine
+  Asteroid asteroid(config, numCores,
+                    deterministic ? Random::DeriveSeed(seed, numCores) : Random::Generator().Next());
+  if (deterministic) {
+    asteroid.SetLockstep();
+  }
+
+  Coord::SetGlobalBounds(config.width, config.height);
 
-  Coord::SetGlobalBounds(Params::kWidth, Params::kHeight);
+  for (unsigned i = 0; i < numCores; ++i) {
+    engines[i] = EvolEngine(config, &asteroid, i, numCores);
+    if (deterministic) {
+      engines[i].SetRandomSeed(Random::DeriveSeed(seed, i));
+    }
+    engines[i].SetMaxTurns(max_turns);
+  }
 
+  if (resume_filename != nullptr) {
+    if (!asteroid.RestoreCheckpoint(checkpoint)) {
+      return 1;
+    }
+    for (unsigned i = 0; i < numCores; ++i) {
+      if (!engines[i].RestoreCheckpoint(checkpoint)) {
+        return 1;
+      }
+    }
+    if (!checkpoint.Done()) {
+      return 1;
+    }
+  } else {
+    for (unsigned i = 0; i < numCores; ++i) {
+      engines[i].Seed(config.starting_lifeforms);
+    }
+  }
+
+  // Engines stop here when a checkpoint is due
+  const bool checkpointing = !config.checkpoint_filename.empty();
+  PausePoint pause(numCores);
   for (unsigned i = 0; i < numCores; ++i) {
-    engines[i] = EvolEngine(Params::kWidth, Params::kHeight, &asteroid);
-    engines[i].Seed(Params::kStartingLifeforms);
+    if (checkpointing) {
+      engines[i].SetPausePoint(&pause);
+    }
     engine_threads[i] = std::thread(&EvolEngine::Run, &engines[i]);
   }
 
+  // Thread which checkpoints the simulation every few minutes
+  Checkpointer checkpointer(&engines, &asteroid, &pause, config);
+  if (checkpointing) {
+    checkpointer.Start();
+  }
+
   // Thread which dumps lifeforms to JSON output every few seconds
-  Dumper dumper(&engines, Params::kJsonDumpIntervalSeconds);
-#if EVOL_RENDERER_CURSES || EVOL_RENDERER_SFML
-  // Dumper is also disabled if no renderer used
+  const std::string & format = config.dump_format;
+  Dumper dumper(&engines, config.json_dump_interval_seconds,
+                format == "json" || format == "both" ? config.json_dump_filename : std::string(),
+                format == "binary" || format == "both" ? config.snapshot_dump_filename : std::string(),
+                format == "genomes" ? config.json_dump_filename : std::string());
   dumper.Start();
-#endif
 
-  // Renderer thread; this updates the screen and waits for user quit
-#if EVOL_RENDERER_CURSES
-  CursesRenderer renderer(&engines, &asteroid, 30);
-#elif EVOL_RENDERER_SFML
-  SFMLRenderer renderer(&engines, &asteroid, 30);
-#endif
-#if EVOL_RENDERER_CURSES || EVOL_RENDERER_SFML
-  renderer.Init();
-  renderer.Run();
-#else
-  // Fallback for no renderer (useful for gdb)
-  for (;;) {
-    sleep(1);
-  }
-#endif
+  // Either way the run ends through StopEngines(), so a signal still gets a
+  // final checkpoint.  Installed before the renderer starts, so curses
+  // leaves them alone.
+  signal(SIGINT, HandleExitSignal);
+  signal(SIGTERM, HandleExitSignal);
 
-#if EVOL_RENDERER_CURSES || EVOL_RENDERER_SFML
-  dumper.DoExit();
-#endif
+  if (headless) {
+    WaitForHeadlessRun(engines, max_seconds);
 
-  for (unsigned i = 0; i < numCores; ++i) {
-    engines[i].DoExit();
-  }
+    // Stop the engines first so the Dumper's final dump is the final
+    // population
+    StopEngines(engines, asteroid, checkpointing ? &checkpointer : nullptr, pause);
+    for (unsigned i = 0; i < numCores; ++i) {
+      engine_threads[i].join();
+    }
+    dumper.DoExit();
+    dumper.JoinThread();
 
+    PrintThroughput(engines);
+    PrintMigration(asteroid);
+  } else {
 #if EVOL_RENDERER_CURSES || EVOL_RENDERER_SFML
-  dumper.JoinThread();
-#endif
+    // Renderer thread; this updates the screen and waits for user quit or
+    // an exit signal
+#  if EVOL_RENDERER_CURSES
+    CursesRenderer renderer(&engines, &asteroid, 30);
+#  elif EVOL_RENDERER_SFML
+    SFMLRenderer renderer(&engines, &asteroid, 30);
+#  endif
+    renderer.Init();
+    renderer.Run(&got_exit_signal);
 
-  for (unsigned i = 0; i < numCores; ++i) {
-    engine_threads[i].join();
-  }
+    // As headless: engines first, so the final dump is the final population
+    StopEngines(engines, asteroid, checkpointing ? &checkpointer : nullptr, pause);
+    for (unsigned i = 0; i < numCores; ++i) {
+      engine_threads[i].join();
+    }
+    dumper.DoExit();
+    dumper.JoinThread();
 
-#if EVOL_RENDERER_CURSES || EVOL_RENDERER_SFML
-  renderer.Cleanup();
+    renderer.Cleanup();
 #endif
+  }
   puts("Exiting normally");
 
   return 0;
@@ -0,0 +1,152 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "Mutation.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>  // abort()
+
+#include "Config.h"
+#include "Random.h"
+
+namespace evol {
+
+
+const Dna * Mutation::Mutate(const Dna & dna, const Config & config) {
+  rolled_ = 0;
+  num_edits_ = 0;
+  const int32_t d100 = Draw(static_cast<uint32_t>(config.mutation_die_roll) + 1);
+  if (d100 >= config.one_mutation)
+    rolled_ = 1;
+  if (d100 >= config.two_mutations)
+    rolled_ = 2;
+
+  // For each mutation:
+  // - Decide quantity N, 1 <= N <= L where L is the upper limit
+  //   config.max_mutation_length
+  // - Copy the input to the next scratch buffer, doing that mutation on the
+  //   way
+  const Dna * in = &dna;
+  for (int i = 0; i < rolled_; i++) {
+    const int32_t size = in->size();
+    Edit & edit = edits_[num_edits_];
+    edit.start = Draw(size + 1);
+    // randomly generated len must be guaranteed never to be past the end of
+    // Dna -- this greatly simplifies the mutation implementations
+    edit.len = Draw(std::min(config.max_mutation_length, size - edit.start) + 1);
+    if (edit.len < 1 || edit.start == size)
+      break;
+    edit.type = static_cast<Type>(Draw(4));
+    edit.target = edit.type == Type::TRANSLATE ? Draw(size - edit.len + 1) : edit.start;
+
+    Dna & out = scratch_[num_edits_++];
+    switch (edit.type) {
+      case Type::INSERT:
+        Insert(*in, out, edit);
+        break;
+      case Type::DELETE:
+        Delete(*in, out, edit);
+        break;
+      case Type::CHANGE:
+        Change(*in, out, edit);
+        break;
+      case Type::TRANSLATE:
+        Translate(*in, out, edit);
+        break;
+      default:
+        // Should never happen
+        abort();
+    }
+    in = &out;
+  }
+
+  return num_edits_ > 0 ? in : nullptr;
+}
+
+
+/**
+ * Lemire's multiply-and-shift, as in Xoshiro256::Bounded(), taking each
+ * 32-bit value from the batch.
+ */
+uint32_t Mutation::Draw(uint32_t range) {
+  uint64_t m = static_cast<uint64_t>(draws_.Next()) * range;
+  uint32_t low = static_cast<uint32_t>(m);
+  if (low < range) {
+    const uint32_t threshold = -range % range;
+    while (low < threshold) {
+      m = static_cast<uint64_t>(draws_.Next()) * range;
+      low = static_cast<uint32_t>(m);
+    }
+  }
+  return m >> 32;
+}
+
+
+/**
+ * Insert Dna at the edit's offset with its length.  All codes so inserted
+ * are OpCode::NOP.
+ */
+void Mutation::Insert(const Dna & in, Dna & out, const Edit & edit) {
+  const OpCode * split = in.begin() + edit.start;
+  out.reserve(in.size() + edit.len);
+  out.assign(in.begin(), split);
+  out.insert(out.end(), edit.len, OpCode::NOP);
+  out.insert(out.end(), split, in.end());
+}
+
+
+/**
+ * Delete the edit's length of Dna at its offset.
+ */
+void Mutation::Delete(const Dna & in, Dna & out, const Edit & edit) {
+  const OpCode * start = in.begin() + edit.start;
+  out.assign(in.begin(), start);
+  out.insert(out.end(), start + edit.len, in.end());
+}
+
+
+/**
+ * Scramble the edit's length of Dna at its offset.
+ */
+void Mutation::Change(const Dna & in, Dna & out, const Edit & edit) {
+  const OpCode * start = in.begin() + edit.start;
+  out.assign(in.begin(), start);
+  for (int32_t i = 0; i < edit.len; ++i) {
+    out.push_back(static_cast<OpCode>(kOpcodeBegin + Draw(kOpcodeEnd - kOpcodeBegin + 1)));
+  }
+  out.insert(out.end(), start + edit.len, in.end());
+}
+
+
+/**
+ * Swap the edit's source range S of Dna with its target range T.  S takes
+ * the opcodes of T, then T the original opcodes of S, so where they overlap
+ * T wins.  If T starts before S and overlaps it, S is filled reading T as S
+ * is being written, so the part of T before S repeats through the rest of S.
+ */
+void Mutation::Translate(const Dna & in, Dna & out, const Edit & edit) {
+  out.assign(in.begin(), in.end());
+  if (edit.target == edit.start)
+    return;
+
+  const OpCode * src = in.data();
+  OpCode * dst = out.data();
+  const int32_t period = edit.target < edit.start ?
+      std::min(edit.start - edit.target, edit.len) : edit.len;
+  for (int32_t i = 0; i < edit.len; ++i) {
+    dst[edit.start + i] = src[edit.target + i % period];
+  }
+  for (int32_t i = 0; i < edit.len; ++i) {
+    dst[edit.target + i] = src[edit.start + i];
+  }
+}
+
+
+}  // namespace evol
@@ -0,0 +1,103 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_MUTATION_H_
+#define EVOL_MUTATION_H_
+
+#include <cstdint>
+
+#include "Config.h"
+#include "Dna.h"
+#include "Random.h"
+#include "Span.h"
+#include "Types.h"
+
+namespace evol {
+
+
+/**
+ * Makes mutated copies of Dna.  Mutation odds and lengths come from the
+ * config: a die is rolled in [0, mutation_die_roll], calling for one
+ * mutation if it comes up one_mutation or more and two if two_mutations or
+ * more.  Each mutation starts at a uniform offset in [0, size] and runs a
+ * uniform length in [0, min(max_mutation_length, size - start)], never past
+ * the end; a zero length, or a start at the very end, ends mutating early.
+ * Then it is equally likely to be an insert, delete, change or translate.
+ *
+ * Every random decision is taken from a batch of raw draws which is refilled
+ * in bulk, and each mutation is done while copying its input into one of two
+ * scratch buffers, so in steady state mutating doesn't allocate.  A Mutation
+ * is used by one engine at a time, since the scratch buffers are shared.
+ */
+class Mutation {
+ public:
+  enum class Type : int32_t { INSERT, DELETE, CHANGE, TRANSLATE };
+
+  /**
+   * One mutation performed: len opcodes at start.  A translate swaps them
+   * with len opcodes at target.
+   */
+  struct Edit {
+    Type type;
+    int32_t start;
+    int32_t len;
+    int32_t target;
+  };
+
+  // The most mutations one copy can get
+  static constexpr int kMaxMutations = 2;
+
+  // Raw 32-bit draws, the full range of uint32_t
+  typedef RandomBatch<uint32_t> Batch;
+
+  Mutation() : draws_(INT32_MIN, INT32_MAX) {}
+
+  /**
+   * Roll for mutations of a copy of the given Dna, and perform them.
+   * Returns the mutated copy, which lasts until the next call, or nullptr if
+   * the copy would be unchanged and the original can be shared instead.
+   */
+  const Dna * Mutate(const Dna & dna, const Config & config);
+
+  /**
+   * What the last Mutate() did: how many mutations the die called for, and
+   * the ones which were performed, in order.
+   */
+  int Rolled() const { return rolled_; }
+  Span<const Edit> Edits() const { return Span<const Edit>(edits_, num_edits_); }
+
+  /**
+   * The draws not yet used, for saving and restoring a Mutation along with
+   * the random stream which refills it.
+   */
+  Span<const uint32_t> Remaining() const { return draws_.Remaining(); }
+  void SetRemaining(Span<const uint32_t> draws) { draws_.SetRemaining(draws); }
+
+ private:
+  /**
+   * Return a uniform value in [0, range) from the batch, range > 0.
+   */
+  uint32_t Draw(uint32_t range);
+
+  // See Mutation.cc for explanations
+  static void Insert(const Dna &, Dna &, const Edit &);
+  static void Delete(const Dna &, Dna &, const Edit &);
+  void Change(const Dna &, Dna &, const Edit &);
+  static void Translate(const Dna &, Dna &, const Edit &);
+
+  Batch draws_;
+  Dna scratch_[kMaxMutations];
+  int rolled_ = 0;
+  int num_edits_ = 0;
+  Edit edits_[kMaxMutations];
+};
+
+
+}  // namespace evol
+#endif  // EVOL_MUTATION_H_
@@ -10,12 +10,15 @@
 #ifndef EVOL_PARAMS_H_
 #define EVOL_PARAMS_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>  // std::hash
 
 namespace evol {
 
 
+// Defaults for the runtime Config (see Config.h).  Engines running with these
+// values get them folded in at compile time; see EnginePolicy.h.
 namespace Params {
 /* Main.cc */
 
@@ -32,13 +35,35 @@ namespace Params {
   // Number of starting lifeforms to seed
   static constexpr int kStartingLifeforms = 10;
 
+  // Helper threads per engine, which share its Dna evaluation and split its
+  // arena into horizontal strips for the other phases of a turn.  0 helpers
+  // runs everything on the engine thread alone.  Dna is evaluated in chunks
+  // of kEvalChunkSize lifeforms, and there are kStripsPerWorker strips per
+  // thread so a crowded strip doesn't hold up the rest
+  static constexpr int kWorkerThreads = 0;
+  static constexpr size_t kEvalChunkSize = 1024;
+  static constexpr int kStripsPerWorker = 4;
+
   ////////////////////////////////////////////////////////////////////////////
   // Asteroid settings
 
-  // Max number of lifeforms that can be on asteroid
-  static constexpr int kAsteroidSize = 128;
+  // How lifeforms migrate between engines: "all" (every engine to every
+  // other), "ring", "torus" or "random" (kMigrationDegree edges out of and
+  // into each engine).  See Asteroid.h
+  static constexpr const char *kMigrationTopology = "all";
+  static constexpr int kMigrationDegree = 4;
+
+  // Max number of lifeforms that can wait on each edge between engines
+  static constexpr int kAsteroidSize = 32;
+
+  // What launching onto a full edge does: evict the lifeform which has
+  // waited longest (true), or send the launched one back to its arena (false)
+  static constexpr bool kAsteroidEvictOnFull = true;
 
-  // Interval in # of turns when we should launch/land a lifeform from any
+  // Lifeforms launched or landed at a time
+  static constexpr int kMigrationBatch = 1;
+
+  // Interval in # of turns when we should launch/land lifeforms from any
   // given engine.  0 means never
   static constexpr uint64_t kLifeformAsteroidLaunchInterval = 12000;
   static constexpr uint64_t kLifeformAsteroidLandInterval = 13000;
@@ -62,11 +87,30 @@ namespace Params {
   static constexpr float kRandomMoveCost = 1.0;
 
   ////////////////////////////////////////////////////////////////////////////
-  // JSON dump settings
+  // Dump settings
 
-  // Time interval for JSON dump of extant lifeforms
+  // Time interval for dump of extant lifeforms
   static constexpr int kJsonDumpIntervalSeconds = 60;
 
+  // File the JSON dump is written to
+  static constexpr const char *kJsonDumpFilename = "lifeform-dump.json";
+
+  // Format of the dump: "json", "binary" (a SnapshotFile.h snapshot, which
+  // evol-dump2json converts to JSON), "both", or "genomes" (JSON with each
+  // distinct Dna written once, see WriteGenomesJson())
+  static constexpr const char *kDumpFormat = "json";
+  static constexpr const char *kSnapshotDumpFilename = "lifeform-dump.snap";
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Checkpoint settings
+
+  // File a checkpoint of the whole simulation is written to, every so often
+  // and on exit, for --resume.  Empty means don't checkpoint.
+  static constexpr const char *kCheckpointFilename = "";
+
+  // Time interval between checkpoints
+  static constexpr int kCheckpointIntervalSeconds = 600;
+
   ////////////////////////////////////////////////////////////////////////////
   // Lifeform Dna code parameters
 
@@ -0,0 +1,136 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_PAUSE_POINT_H_
+#define EVOL_PAUSE_POINT_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace evol {
+
+
+/**
+ * Brings every engine to a halt between turns, all on the same turn, so a
+ * checkpoint can be taken of the lot.  Engines check in at the top of every
+ * turn, saying which turn it is.  Pause() picks the turn after the furthest
+ * any engine has checked in on, a turn none has started yet; engines park
+ * when they reach it, and the ones behind carry on until they catch up.
+ * (Parking each where it stands wouldn't do: in lockstep an engine ahead may
+ * be waiting at the asteroid for one behind.)
+ *
+ * Checking in costs an atomic store and load unless a pause is pending.
+ */
+class PausePoint {
+ public:
+  explicit PausePoint(unsigned num_engines)
+      : requested_(false), turns_(num_engines), running_(num_engines), parked_(0), turn_(0),
+        pauses_(0) {
+    for (auto & t : turns_) {
+      t.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  PausePoint(const PausePoint &) = delete;
+  PausePoint & operator=(const PausePoint &) = delete;
+
+  /**
+   * Engine side: called by the given engine at the top of every turn.
+   * Returns true if a pause is pending, in which case the engine calls
+   * Wait().
+   */
+  bool CheckIn(unsigned engine, uint64_t turn) {
+    // Sequentially consistent, against Pause() raising the flag then reading
+    // the turns: either it sees this turn, or we see the flag
+    turns_[engine].store(turn);
+    return requested_.load();
+  }
+
+  /**
+   * Engine side: called at the top of the given turn once CheckIn() has
+   * returned true.  Returns at once if the engine has yet to reach the pause
+   * turn, else once Resume() is called (or the pause turn moves on).
+   */
+  void Wait(uint64_t turn) {
+    std::unique_lock<std::mutex> ul(mutex_);
+    if (!requested_) {
+      return;
+    }
+    if (turn > turn_) {
+      // Only an engine on its first check-in, say just resumed from a
+      // checkpoint, can be past the pause turn.  Everyone parked so far is
+      // behind it now; they need to catch up.
+      turn_ = turn;
+      parked_ = 0;
+      cv_.notify_all();
+    }
+    if (turn < turn_) {
+      return;
+    }
+    ++parked_;
+    cv_.notify_all();
+    const uint64_t pause = pauses_;
+    cv_.wait(ul, [&] { return pauses_ != pause || turn_ > turn; });
+  }
+
+  /**
+   * Engine side: the engine has stopped for good, so is no longer waited
+   * for.
+   */
+  void Leave(unsigned engine) {
+    std::lock_guard<std::mutex> lg(mutex_);
+    turns_[engine].store(0);
+    --running_;
+    cv_.notify_all();
+  }
+
+  /**
+   * Returns once every engine still running is parked on the same turn.
+   */
+  void Pause() {
+    std::unique_lock<std::mutex> ul(mutex_);
+    requested_.store(true);
+    uint64_t furthest = 0;
+    for (auto & t : turns_) {
+      furthest = std::max(furthest, t.load());
+    }
+    turn_ = furthest + 1;
+    parked_ = 0;
+    cv_.wait(ul, [&] { return parked_ == running_; });
+  }
+
+  /**
+   * Let the engines go again.
+   */
+  void Resume() {
+    std::lock_guard<std::mutex> lg(mutex_);
+    requested_.store(false);
+    parked_ = 0;
+    ++pauses_;
+    cv_.notify_all();
+  }
+
+ private:
+  std::atomic<bool> requested_;
+  std::vector<std::atomic<uint64_t>> turns_;  // each engine's latest check-in
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  unsigned running_;
+  unsigned parked_;   // engines parked on turn_
+  uint64_t turn_;     // the turn to park on
+  uint64_t pauses_;   // number of Resume()s, so parked engines can tell
+};
+
+
+}  // namespace evol
+#endif  // EVOL_PAUSE_POINT_H_
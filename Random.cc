@@ -9,13 +9,34 @@
 
 #include "Random.h"
 
-#include <memory>
-#include <random>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
 namespace evol {
 
 
-std::unique_ptr<std::default_random_engine> Random::rand_generator_(nullptr);
+namespace {
+
+/**
+ * Seed for a thread which didn't pick its own: the clock and pid, plus a
+ * counter so threads starting in the same tick still get distinct streams.
+ */
+uint64_t ClockSeed() {
+  static std::atomic<uint64_t> threads(0);
+  uint64_t seed = std::chrono::system_clock::now().time_since_epoch().count();
+  seed ^= static_cast<uint64_t>(getpid()) << 32;
+  seed += threads.fetch_add(1, std::memory_order_relaxed) * 0x9e3779b97f4a7c15;
+  return seed;
+}
+
+}  // namespace anon
+
+
+thread_local Xoshiro256 Random::generator_(ClockSeed());
 
 
 }  // namespace evol
@@ -10,35 +10,204 @@
 #ifndef EVOL_RANDOM_H_
 #define EVOL_RANDOM_H_
 
-#include <unistd.h>
-#include <sys/types.h>
-
-#include <chrono>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
-#include <memory>
-#include <random>
+
+#include "Span.h"
 
 namespace evol {
 
 
+/**
+ * xoshiro256** by Blackman and Vigna: 256 bits of state, a handful of
+ * shifts and rotates per 64-bit result, and statistically far better than
+ * std::default_random_engine.
+ */
+class Xoshiro256 {
+ public:
+  /**
+   * Seed the full state from one 64-bit value via splitmix64, as the authors
+   * recommend.  Any seed (including 0) gives a usable state.
+   */
+  explicit Xoshiro256(uint64_t seed = 0) { Seed(seed); }
+
+  void Seed(uint64_t seed) {
+    for (auto & s : state_) {
+      seed += 0x9e3779b97f4a7c15;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      s = z ^ (z >> 31);
+    }
+  }
+
+  uint64_t Next() {
+    const uint64_t result = Rotl(state_[1] * 5, 7) * 9;
+    const uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = Rotl(state_[3], 45);
+    return result;
+  }
+
+  /**
+   * Return an unbiased uint32_t in [0, range), or any uint32_t if range is 0.
+   * This is Lemire's multiply-and-shift method, which only divides in the
+   * rare case a draw lands in the biased zone.
+   */
+  uint32_t Bounded(uint32_t range) {
+    uint32_t x = Next() >> 32;
+    uint64_t m = static_cast<uint64_t>(x) * range;
+    uint32_t low = static_cast<uint32_t>(m);
+    if (low < range) {
+      const uint32_t threshold = -range % range;
+      while (low < threshold) {
+        x = Next() >> 32;
+        m = static_cast<uint64_t>(x) * range;
+        low = static_cast<uint32_t>(m);
+      }
+    }
+    return range == 0 ? x : m >> 32;
+  }
+
+  /**
+   * Raw state, for saving and restoring a stream.
+   */
+  const std::array<uint64_t, 4> & State() const { return state_; }
+  void SetState(const std::array<uint64_t, 4> & state) { state_ = state; }
+
+ private:
+  static uint64_t Rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  std::array<uint64_t, 4> state_;
+};
+
+
+/**
+ * Random numbers for the simulation.  Each thread draws from its own
+ * generator, so engines running on separate threads never contend (or race)
+ * over generator state.  A thread's generator is seeded from the clock the
+ * first time it is used, unless Seed() is called first.
+ */
 class Random {
  public:
   /**
    * Return a random int32_t in range [min, max].
    */
   static int32_t Int32(int32_t min, int32_t max) {
-    if (Random::rand_generator_ == nullptr) {
-      auto seed = std::chrono::system_clock::now().time_since_epoch().count();
-      seed ^= getpid();
-      rand_generator_.reset(new std::default_random_engine(seed));
+    // Unsigned arithmetic wraps rather than overflowing for wide ranges
+    const uint32_t range = static_cast<uint32_t>(max) - static_cast<uint32_t>(min) + 1;
+    return static_cast<int32_t>(static_cast<uint32_t>(min) + Generator().Bounded(range));
+  }
+
+  /**
+   * Fill out[0..n) with random values in range [min, max], converted to T.
+   * Cheaper than n calls to Int32() since the range is only worked out once
+   * and the generator stays in registers.
+   */
+  template <typename T>
+  static void Fill(T *out, size_t n, int32_t min, int32_t max) {
+    Xoshiro256 & gen = Generator();
+    const uint32_t range = static_cast<uint32_t>(max) - static_cast<uint32_t>(min) + 1;
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = static_cast<T>(static_cast<int32_t>(static_cast<uint32_t>(min) + gen.Bounded(range)));
+    }
+  }
+
+  /**
+   * Reseed the calling thread's generator.
+   */
+  static void Seed(uint64_t seed) { Generator().Seed(seed); }
+
+  /**
+   * Return the calling thread's generator.
+   */
+  static Xoshiro256 & Generator() { return generator_; }
+
+  /**
+   * Derive the seed of an independent stream from a master seed and a stream
+   * number, e.g. one stream per engine.
+   */
+  static uint64_t DeriveSeed(uint64_t seed, uint64_t stream) {
+    Xoshiro256 gen(seed ^ (stream * 0xd1b54a32d192ed03));
+    return gen.Next();
+  }
+
+ private:
+  static thread_local Xoshiro256 generator_;
+};
+
+
+/**
+ * Make the given generator the calling thread's for the guard's lifetime,
+ * then hand its advanced state back.  This lets an object own its random
+ * stream while everything it calls keeps using Random.
+ */
+class ScopedGenerator {
+ public:
+  explicit ScopedGenerator(Xoshiro256 & gen) : gen_(gen), saved_(Random::Generator()) {
+    Random::Generator() = gen_;
+  }
+  ~ScopedGenerator() {
+    gen_ = Random::Generator();
+    Random::Generator() = saved_;
+  }
+
+  ScopedGenerator(const ScopedGenerator &) = delete;
+  ScopedGenerator & operator=(const ScopedGenerator &) = delete;
+
+ private:
+  Xoshiro256 & gen_;
+  Xoshiro256 saved_;
+};
+
+
+/**
+ * A run of N pre-drawn random values in [min, max], refilled with one
+ * Random::Fill() whenever it runs dry.  Suits hot loops which draw from the
+ * same range over and over.
+ */
+template <typename T, size_t N = 256>
+class RandomBatch {
+ public:
+  static constexpr size_t kSize = N;
+
+  RandomBatch(int32_t min, int32_t max) : min_(min), max_(max), next_(N) {}
+
+  T Next() {
+    if (next_ == N) {
+      Random::Fill(values_.data(), N, min_, max_);
+      next_ = 0;
     }
+    return values_[next_++];
+  }
 
-    std::uniform_int_distribution<int32_t> die_roll(min, max);
-    return die_roll(*rand_generator_);
+  /**
+   * The values still to be handed out, for saving and restoring a batch
+   * along with its generator.  SetRemaining() needs at most N values.
+   */
+  Span<const T> Remaining() const {
+    return Span<const T>(values_.data() + next_, N - next_);
+  }
+  void SetRemaining(Span<const T> values) {
+    assert(values.size() <= N);
+    next_ = N - values.size();
+    std::copy(values.begin(), values.end(), values_.begin() + next_);
   }
 
  private:
-  static std::unique_ptr<std::default_random_engine> rand_generator_;
+  int32_t min_;
+  int32_t max_;
+  size_t next_;
+  std::array<T, N> values_;
 };
 
 
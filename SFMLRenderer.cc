@@ -45,12 +45,12 @@ void SFMLRenderer::Init() {
 }
 
 
-void SFMLRenderer::Run() {
+void SFMLRenderer::Run(const volatile sig_atomic_t * exit_signal) {
   if (!did_init_) {
     abort();
   }
 
-  while (sfWindow_.isOpen()) {
+  while (sfWindow_.isOpen() && !*exit_signal) {
     sf::Event event;
     while (sfWindow_.pollEvent(event)) {
       switch (event.type) {
@@ -140,9 +140,11 @@ void SFMLRenderer::RenderOverview() {
       auto & arena = e.GetArena();
       num_alive = arena.NumLifeforms();
       num_dead = arena.NumDeadLifeforms();
-      for (const auto & lf : arena.Lifeforms()) {
-        dna_count += lf->GetDnaSize();
-        highest_gen = std::max(highest_gen, lf->Gen());
+      for (auto dna_size : arena.Lifeforms().DnaSizes()) {
+        dna_count += dna_size;
+      }
+      for (auto gen : arena.Lifeforms().Gens()) {
+        highest_gen = std::max(highest_gen, gen);
       }
       tstats = e.GetTimers().front()->GetStats();  // theoretically this returns multiple timers, implement one for now
     }
@@ -8,6 +8,7 @@
  */
 
 #pragma once
+#include <csignal>
 #include <cstdint>
 #include <vector>
 #include <SFML/Graphics.hpp>
@@ -38,7 +39,10 @@ class SFMLRenderer {
   SFMLRenderer & operator=(const SFMLRenderer &) = delete;
 
   void Init();
-  void Run();
+  /**
+   * Render until the user quits or *exit_signal becomes nonzero.
+   */
+  void Run(const volatile sig_atomic_t * exit_signal);
   void Cleanup();
 
  private:
@@ -0,0 +1,181 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "SnapshotFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "BufferedWriter.h"
+
+namespace evol {
+
+
+namespace {
+
+uint64_t Align8(uint64_t offset) {
+  return (offset + 7) & ~uint64_t(7);
+}
+
+void Pad(BufferedWriter & out, uint64_t from, uint64_t to) {
+  static const char kZeros[8] = {};
+  out.Put(kZeros, to - from);
+}
+
+}  // namespace anon
+
+
+bool WriteLifeformsSnapshot(const std::vector<LifeformSnapshot> & snapshots,
+                            const std::string & filename) {
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+  header.byte_order = kSnapshotByteOrder;
+  header.version = kSnapshotVersion;
+  header.num_sections = snapshots.size();
+  for (auto & snapshot : snapshots) {
+    header.num_records += snapshot.Size();
+    header.dna_bytes += snapshot.AllDna().size();
+  }
+  header.sections_offset = sizeof(header);
+  header.records_offset = Align8(header.sections_offset + sizeof(SnapshotSection) * header.num_sections);
+  header.dna_offset = Align8(header.records_offset + sizeof(SnapshotRecord) * header.num_records);
+
+  return WriteFileAtomically(filename, [&](BufferedWriter & out) {
+    out.PutRaw(header);
+
+    uint64_t first_record = 0;
+    for (uint32_t i = 0; i < snapshots.size(); ++i) {
+      SnapshotSection section = {i, 0, first_record, snapshots[i].Size()};
+      out.PutRaw(section);
+      first_record += snapshots[i].Size();
+    }
+    Pad(out, header.sections_offset + sizeof(SnapshotSection) * header.num_sections,
+        header.records_offset);
+
+    uint64_t dna_base = 0;
+    for (auto & snapshot : snapshots) {
+      for (size_t lf = 0; lf < snapshot.Size(); ++lf) {
+        const LifeformSnapshot::Record & r = snapshot.Get(lf);
+        SnapshotRecord record = {r.id, r.gen, dna_base + r.dna_begin, r.dna_size, r.energy,
+                                 r.alive ? uint32_t(SnapshotRecord::ALIVE) : 0, 0};
+        out.PutRaw(record);
+      }
+      dna_base += snapshot.AllDna().size();
+    }
+    Pad(out, header.records_offset + sizeof(SnapshotRecord) * header.num_records, header.dna_offset);
+
+    for (auto & snapshot : snapshots) {
+      Span<const OpCode> dna = snapshot.AllDna();
+      out.Put(reinterpret_cast<const char *>(dna.data()), dna.size());
+    }
+  });
+}
+
+
+bool SnapshotReader::Open(const std::string & filename) {
+  Close();
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Can't open %s: %s\n", filename.c_str(), strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    fprintf(stderr, "Can't stat %s: %s\n", filename.c_str(), strerror(errno));
+    close(fd);
+    return false;
+  }
+  if (size_t(st.st_size) < sizeof(SnapshotHeader)) {
+    fprintf(stderr, "%s is too short to be a snapshot\n", filename.c_str());
+    close(fd);
+    return false;
+  }
+
+  size_ = st.st_size;
+  data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data_ == MAP_FAILED) {
+    fprintf(stderr, "Can't map %s: %s\n", filename.c_str(), strerror(errno));
+    data_ = nullptr;
+    return false;
+  }
+
+  if (!Check(filename)) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+
+void SnapshotReader::Close() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+
+bool SnapshotReader::Check(const std::string & filename) const {
+  const SnapshotHeader & h = Header();
+  const char *error = nullptr;
+
+  // Does [offset, offset + count * size) fit in the file?  Careful of
+  // overflow, as the counts are untrusted.
+  auto fits = [this](uint64_t offset, uint64_t count, uint64_t size) {
+    return offset % 8 == 0 && offset <= size_ && count <= (size_ - offset) / size;
+  };
+
+  if (memcmp(h.magic, kSnapshotMagic, sizeof(h.magic)) != 0)
+    error = "not a snapshot file";
+  else if (h.byte_order != kSnapshotByteOrder)
+    error = "written on a machine of different byte order";
+  else if (h.version != kSnapshotVersion)
+    error = "unsupported snapshot version";
+  else if (!fits(h.sections_offset, h.num_sections, sizeof(SnapshotSection)) ||
+           !fits(h.records_offset, h.num_records, sizeof(SnapshotRecord)) ||
+           !fits(h.dna_offset, h.dna_bytes, 1))
+    error = "truncated or corrupt";
+
+  if (!error) {
+    for (auto & section : Sections()) {
+      if (section.first_record > h.num_records ||
+          section.num_records > h.num_records - section.first_record) {
+        error = "engine section out of range";
+        break;
+      }
+    }
+  }
+  if (!error) {
+    for (auto & record : Records()) {
+      if (record.dna_begin > h.dna_bytes || record.dna_size > h.dna_bytes - record.dna_begin) {
+        error = "lifeform Dna out of range";
+        break;
+      }
+    }
+  }
+
+  if (error) {
+    fprintf(stderr, "Bad snapshot %s: %s\n", filename.c_str(), error);
+    return false;
+  }
+  return true;
+}
+
+
+}  // namespace evol
@@ -0,0 +1,142 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_SNAPSHOT_FILE_H_
+#define EVOL_SNAPSHOT_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "LifeformSnapshot.h"
+#include "Span.h"
+#include "Types.h"
+
+namespace evol {
+
+
+/**
+ * Binary population snapshot format.  A file is laid out as:
+ *
+ *   SnapshotHeader
+ *   SnapshotSection[num_sections]    one per engine
+ *   SnapshotRecord[num_records]      all engines' lifeforms, engine by engine
+ *   OpCode[dna_bytes]                all lifeforms' Dna end to end
+ *
+ * Every part starts at the offset given in the header, 8-byte aligned, and
+ * holds plain fixed-size structs in the writer's byte order, so a reader can
+ * mmap() the file and use it in place (see SnapshotReader).  Readers check
+ * magic, byte_order and version and refuse anything else; any change to the
+ * layout must bump kSnapshotVersion.
+ */
+constexpr char kSnapshotMagic[8] = {'E', 'V', 'O', 'L', 'S', 'N', 'A', 'P'};
+constexpr uint32_t kSnapshotByteOrder = 0x01020304;
+constexpr uint32_t kSnapshotVersion = 1;
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t version;
+  uint32_t num_sections;
+  uint32_t reserved;
+  uint64_t num_records;
+  uint64_t dna_bytes;
+  uint64_t sections_offset;
+  uint64_t records_offset;
+  uint64_t dna_offset;
+};
+
+struct SnapshotSection {
+  uint32_t engine;
+  uint32_t reserved;
+  uint64_t first_record;
+  uint64_t num_records;
+};
+
+struct SnapshotRecord {
+  enum Flags : uint32_t { ALIVE = 1 };
+
+  uint64_t id;
+  uint64_t gen;
+  uint64_t dna_begin;   // offset into the Dna blob
+  uint32_t dna_size;
+  float energy;
+  uint32_t flags;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "SnapshotHeader layout changed");
+static_assert(sizeof(SnapshotSection) == 24, "SnapshotSection layout changed");
+static_assert(sizeof(SnapshotRecord) == 40, "SnapshotRecord layout changed");
+static_assert(std::is_trivially_copyable<SnapshotRecord>::value, "SnapshotRecord must be POD");
+static_assert(sizeof(OpCode) == 1, "Dna blob holds one byte per opcode");
+
+
+/**
+ * Write the given snapshots, one section per engine, to filename (via a
+ * temporary file, like WriteLifeformsJson()).  Returns false (after
+ * complaining on stderr) on failure.
+ */
+bool WriteLifeformsSnapshot(const std::vector<LifeformSnapshot> & snapshots,
+                            const std::string & filename);
+
+
+/**
+ * Read-only view of a snapshot file, mapped into memory.  Open() checks the
+ * header and that every part and every record's Dna lies within the file, so
+ * afterwards the accessors can be used without further checks.
+ */
+class SnapshotReader {
+ public:
+  SnapshotReader() : data_(nullptr), size_(0) {}
+  ~SnapshotReader() { Close(); }
+
+  SnapshotReader(const SnapshotReader &) = delete;
+  SnapshotReader & operator=(const SnapshotReader &) = delete;
+
+  /**
+   * Map and check the given file.  Returns false (after complaining on
+   * stderr) if it can't be read or isn't a valid snapshot.
+   */
+  bool Open(const std::string & filename);
+  void Close();
+
+  const SnapshotHeader & Header() const { return *Part<SnapshotHeader>(0); }
+
+  Span<const SnapshotSection> Sections() const {
+    return Span<const SnapshotSection>(Part<SnapshotSection>(Header().sections_offset),
+                                       Header().num_sections);
+  }
+
+  Span<const SnapshotRecord> Records() const {
+    return Span<const SnapshotRecord>(Part<SnapshotRecord>(Header().records_offset),
+                                      Header().num_records);
+  }
+
+  Span<const OpCode> GetDna(const SnapshotRecord & record) const {
+    return Span<const OpCode>(Part<OpCode>(Header().dna_offset + record.dna_begin), record.dna_size);
+  }
+
+ private:
+  template <typename T>
+  const T * Part(uint64_t offset) const {
+    return reinterpret_cast<const T *>(static_cast<const char *>(data_) + offset);
+  }
+
+  bool Check(const std::string & filename) const;
+
+  void *data_;
+  size_t size_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_SNAPSHOT_FILE_H_
@@ -0,0 +1,59 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_SPAN_H_
+#define EVOL_SPAN_H_
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace evol {
+
+
+/**
+ * Non-owning view of a contiguous run of T, i.e. a poor man's C++20 std::span.
+ * Reading through a Span never allocates or copies; it is only valid as long
+ * as the container it was made from isn't resized.
+ */
+template <typename T>
+class Span {
+ public:
+  Span() : data_(nullptr), size_(0) {}
+  Span(T *data, size_t size) : data_(data), size_(size) {}
+
+  // Span<T> converts to Span<const T>
+  template <typename U>
+  Span(const Span<U> & o) : data_(o.data()), size_(o.size()) {}
+
+  template <typename V>
+  Span(std::vector<V> & v) : data_(v.data()), size_(v.size()) {}
+  template <typename V>
+  Span(const std::vector<V> & v) : data_(v.data()), size_(v.size()) {}
+
+  T * begin() const { return data_; }
+  T * end() const { return data_ + size_; }
+
+  T * data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  T & operator[](size_t i) const {
+    assert(i < size_);
+    return data_[i];
+  }
+
+ private:
+  T *data_;
+  size_t size_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_SPAN_H_
@@ -0,0 +1,93 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+namespace evol {
+
+
+ThreadPool::ThreadPool(unsigned helpers)
+    : loops_(0), busy_(0), exit_(false), task_(nullptr), fn_(nullptr), n_(0), chunk_(1), next_(0) {
+  for (unsigned i = 0; i < helpers; ++i) {
+    helpers_.emplace_back(&ThreadPool::HelperLoop, this);
+  }
+}
+
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lg(mutex_);
+    exit_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto & t : helpers_) {
+    t.join();
+  }
+}
+
+
+void ThreadPool::Run(size_t n, size_t chunk, Task task, void *fn) {
+  {
+    std::lock_guard<std::mutex> lg(mutex_);
+    task_ = task;
+    fn_ = fn;
+    n_ = n;
+    chunk_ = chunk;
+    next_.store(0, std::memory_order_relaxed);
+    busy_ = helpers_.size();
+    ++loops_;
+  }
+  start_cv_.notify_all();
+
+  Work();
+
+  std::unique_lock<std::mutex> ul(mutex_);
+  done_cv_.wait(ul, [this] { return busy_ == 0; });
+}
+
+
+void ThreadPool::HelperLoop() {
+  uint64_t loops_seen = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> ul(mutex_);
+      start_cv_.wait(ul, [&] { return loops_ != loops_seen || exit_; });
+      if (exit_) {
+        return;
+      }
+      loops_seen = loops_;
+    }
+
+    Work();
+
+    std::lock_guard<std::mutex> lg(mutex_);
+    if (--busy_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+
+void ThreadPool::Work() {
+  for (;;) {
+    size_t begin = next_.fetch_add(chunk_, std::memory_order_relaxed);
+    if (begin >= n_) {
+      return;
+    }
+    task_(fn_, begin, std::min(begin + chunk_, n_));
+  }
+}
+
+
+}  // namespace evol
@@ -0,0 +1,93 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#ifndef EVOL_THREAD_POOL_H_
+#define EVOL_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace evol {
+
+
+/**
+ * A handful of helper threads which split loops over an index range with the
+ * thread that owns the pool.  Only the owning thread may call ParallelFor().
+ */
+class ThreadPool {
+ public:
+  /**
+   * Start the given number of helper threads.  With 0 helpers ParallelFor()
+   * just runs the loop on the calling thread.
+   */
+  explicit ThreadPool(unsigned helpers);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  /**
+   * Number of threads which work on a ParallelFor(), including the caller.
+   */
+  unsigned NumThreads() const { return helpers_.size() + 1; }
+
+  /**
+   * Call fn(begin, end) for consecutive chunks of [0, n) of up to chunk
+   * indices each, spread over all threads.  Returns once every chunk is
+   * done.  fn must be safe to call concurrently on disjoint chunks.  With no
+   * helpers, or no more than one chunk's work, it's a single fn(0, n).
+   */
+  template <typename Fn>
+  void ParallelFor(size_t n, size_t chunk, Fn & fn) {
+    if (helpers_.empty() || n <= chunk) {
+      fn(0, n);
+      return;
+    }
+    Run(n, chunk, &Trampoline<Fn>, &fn);
+  }
+
+ private:
+  typedef void (*Task)(void *, size_t, size_t);
+
+  template <typename Fn>
+  static void Trampoline(void *fn, size_t begin, size_t end) {
+    (*static_cast<Fn *>(fn))(begin, end);
+  }
+
+  void Run(size_t n, size_t chunk, Task task, void *fn);
+  void HelperLoop();
+
+  // Do chunks of the current loop until there are none left
+  void Work();
+
+  std::vector<std::thread> helpers_;
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_;  // a loop was posted, or exit
+  std::condition_variable done_cv_;   // the last helper finished its chunks
+  uint64_t loops_;                    // number of loops posted so far
+  unsigned busy_;                     // helpers yet to finish current loop
+  bool exit_;
+
+  // The current loop
+  Task task_;
+  void *fn_;
+  size_t n_;
+  size_t chunk_;
+  std::atomic<size_t> next_;
+};
+
+
+}  // namespace evol
+#endif  // EVOL_THREAD_POOL_H_
@@ -10,20 +10,22 @@
 #ifndef EVOL_TYPES_H_
 #define EVOL_TYPES_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <string>
-#include <unordered_map>
+#include <functional>
+#include <vector>
 
 namespace evol {
 
 
-enum class ActionType {
+enum class ActionType : uint8_t {
   NOTHING = 0,
   APOPTOSIS,
   MOVE_NORTH,
   MOVE_EAST,
   MOVE_SOUTH,
   MOVE_WEST,
+  MOVE_RANDOM,  // Resolved to one of the above before the move is made
 };
 
 // Define the range of enum class integers representing moves (for random
@@ -74,9 +76,41 @@ enum class OpCode : OpcodeBasicType {
 const int32_t kOpcodeBegin = static_cast<int32_t>(OpCode::NOP);
 const int32_t kOpcodeEnd = static_cast<int32_t>(OpCode::END) - 1;
 
-// Enum-to-string map (for human-readable serialization); this should
-// be updated in Types.cc when opcodes are changed
-extern const std::unordered_map<OpCode, std::string> kOpcodeStrings;
+// Opcode names (for human-readable serialization), indexed by opcode; this
+// should be updated when opcodes are changed
+constexpr const char * kOpcodeNames[] = {
+  "NOP",
+  "APOPTOSIS",
+  "IS_NORTH_OCCUPIED",
+  "IS_SOUTH_OCCUPIED",
+  "IS_WEST_OCCUPIED",
+  "IS_EAST_OCCUPIED",
+  "IS_CROWDED",
+  "IS_NEIGHBOR",
+  "JMP1",
+  "JMP2",
+  "JMP3",
+  "JMP4",
+  "JMP5",
+  "CJMP1",
+  "CJMP2",
+  "CJMP3",
+  "CJMP4",
+  "CJMP5",
+  "FINAL_MOVE_NORTH",
+  "FINAL_MOVE_EAST",
+  "FINAL_MOVE_SOUTH",
+  "FINAL_MOVE_WEST",
+  "FINAL_MOVE_RANDOM",
+  "END",
+};
+static_assert(sizeof(kOpcodeNames) / sizeof(kOpcodeNames[0]) == static_cast<size_t>(OpCode::END) + 1,
+              "kOpcodeNames must name every opcode");
+
+inline const char * OpcodeName(OpCode opcode) {
+  return static_cast<size_t>(opcode) <= static_cast<size_t>(OpCode::END)
+      ? kOpcodeNames[static_cast<size_t>(opcode)] : "?UNKNOWN?";
+}
 
 }  // namespace evol
 
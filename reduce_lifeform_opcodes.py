@@ -140,6 +140,9 @@ class Lifeform (object):
         if self.dna is None:
             raise LifeformParseError('Missing dna from lifeform')
 
+    def describe(self):
+        return 'Lifeform id {0}, gen {1}'.format(self.id, self.gen)
+
     def run_dna(self, conditions):
         '''
         Run the lifeform's DNA under the given condition(s) and returns
@@ -180,6 +183,29 @@ class Lifeform (object):
         return 'NOTHING'
 
 
+class Genome (Lifeform):
+    '''
+    A distinct Dna from a genomes dump (dump_format = genomes), standing for
+    every lifeform which carries it.
+    '''
+    def __init__(self, raw):
+        try:
+            self.id = int(raw['genome'])
+            self.count = int(raw['count'])
+            self.min_gen = int(raw['min_gen'])
+            self.max_gen = int(raw['max_gen'])
+        except (KeyError, ValueError) as e:
+            raise LifeformParseError('Missing basic stats from genome')
+
+        self.dna = raw.get('dna')
+        if self.dna is None:
+            raise LifeformParseError('Missing dna from genome')
+
+    def describe(self):
+        return 'Genome {0}, {1} lifeforms, gen {2}-{3}'.format(
+            self.id, self.count, self.min_gen, self.max_gen)
+
+
 def print_usage_and_exit(*msg):
     '''
     Print the error message(s) given, a simple usage summary, and exit with
@@ -204,7 +230,7 @@ def analyze(lf):
     '''
     Calculate and print what the lifeform would do under various conditions.
     '''
-    print 'Lifeform id {0}, gen {1}'.format(lf.id, lf.gen)
+    print lf.describe()
     for condition in ALL_CONDITIONS:
         print condition, '->', lf.run_dna(condition)
 
@@ -216,9 +242,14 @@ def main():
     lifeforms = []
     for file in sys.argv[1:]:
         with open(file, "r") as f:
-            lifeforms.extend([Lifeform(l) for l in json.load(f)])
-
-    print 'Loaded {0} lifeforms'.format(len(lifeforms))
+            dump = json.load(f)
+        if isinstance(dump, dict):
+            # Genomes dump: each distinct Dna need only be analyzed once
+            lifeforms.extend([Genome(g) for g in dump['genomes']])
+        else:
+            lifeforms.extend([Lifeform(l) for l in dump])
+
+    print 'Loaded {0} lifeforms or genomes'.format(len(lifeforms))
     print
 
     try:
@@ -0,0 +1,75 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <cstdint>
+
+#include "Arena.h"
+#include "Coord.h"
+#include "DecisionTable.h"
+#include "Dna.h"
+#include "Random.h"
+#include "Types.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+/**
+ * The sensors read square by square, as the Dna describes them.
+ */
+SensorBits ReferenceSense(const Arena & arena, const Coord & c) {
+  SensorBits state = 0;
+  if (arena.NumLifeformsAt(c.North()) > 0)
+    state |= kSensorNorth;
+  if (arena.NumLifeformsAt(c.South()) > 0)
+    state |= kSensorSouth;
+  if (arena.NumLifeformsAt(c.East()) > 0)
+    state |= kSensorEast;
+  if (arena.NumLifeformsAt(c.West()) > 0)
+    state |= kSensorWest;
+  if (arena.NumLifeformsAt(c) > 1)
+    state |= kSensorCrowded;
+  if (arena.AdjacentLifeforms(c))
+    state |= kSensorNeighbor;
+  return state;
+}
+
+}  // namespace anon
+
+
+TEST(ArenaTest, SenseMatchesSquares) {
+  // Odd sizes, to exercise wrapping within and across bitboard words
+  const Unit sizes[][2] = {{1, 1}, {2, 3}, {5, 4}, {63, 2}, {64, 3}, {65, 5}, {130, 4}};
+  Xoshiro256 rng(23);
+  for (const auto & size : sizes) {
+    const Unit width = size[0], height = size[1];
+    Coord::SetGlobalBounds(width, height);
+    Arena arena(width, height);
+    GenomeRef genome = arena.Genomes().Intern(Dna{OpCode::FINAL_MOVE_RANDOM});
+
+    // Sparse enough to leave empty squares, with some crowding
+    const unsigned lifeforms = width * height / 3 + 1;
+    for (unsigned i = 0; i < lifeforms; ++i) {
+      Coord c(rng.Bounded(width), rng.Bounded(height));
+      arena.AddLifeform(0, genome, 1.0f, c);
+    }
+    arena.UpdateSensorBoards();
+
+    for (Unit y = 0; y < height; ++y) {
+      for (Unit x = 0; x < width; ++x) {
+        const Coord c(x, y);
+        ASSERT_EQ(ReferenceSense(arena, c), arena.Sense(c, kNumSensorStates - 1))
+            << width << "x" << height << " at " << x << ", " << y;
+        ASSERT_EQ(ReferenceSense(arena, c) & kSensorEast, arena.Sense(c, kSensorEast));
+      }
+    }
+  }
+}
@@ -0,0 +1,265 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Asteroid.h"
+#include "Config.h"
+#include "Coord.h"
+#include "Dna.h"
+#include "Lifeform.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+typedef std::set<std::pair<unsigned, unsigned>> EdgeSet;
+
+const unsigned kEngineCounts[] = {1, 2, 3, 5, 16};
+
+Config MakeConfig(const std::string & topology) {
+  Config config;
+  config.migration_topology = topology;
+  return config;
+}
+
+/**
+ * The asteroid's edges as (from, to) pairs.  Fails the test on a self-loop
+ * or a repeated edge.
+ */
+EdgeSet Edges(const Asteroid & asteroid) {
+  EdgeSet edges;
+  for (size_t i = 0; i < asteroid.NumEdges(); ++i) {
+    const Asteroid::Edge & e = asteroid.GetEdge(i);
+    EXPECT_NE(e.from, e.to);
+    EXPECT_TRUE(edges.insert(std::make_pair(e.from, e.to)).second)
+        << "repeated edge " << e.from << " -> " << e.to;
+  }
+  return edges;
+}
+
+void ExpectDegrees(const EdgeSet & edges, unsigned n, unsigned degree) {
+  std::vector<unsigned> out(n), in(n);
+  for (auto & e : edges) {
+    ++out[e.first];
+    ++in[e.second];
+  }
+  for (unsigned i = 0; i < n; ++i) {
+    EXPECT_EQ(degree, out[i]) << "engine " << i << " of " << n;
+    EXPECT_EQ(degree, in[i]) << "engine " << i << " of " << n;
+  }
+}
+
+/**
+ * The torus on a rows x cols grid, engines numbered row-major.
+ */
+EdgeSet TorusEdges(unsigned rows, unsigned cols) {
+  EdgeSet edges;
+  for (unsigned y = 0; y < rows; ++y) {
+    for (unsigned x = 0; x < cols; ++x) {
+      const unsigned from = y * cols + x;
+      const unsigned to[] = {y * cols + (x + 1) % cols, y * cols + (x + cols - 1) % cols,
+                             (y + 1) % rows * cols + x, (y + rows - 1) % rows * cols + x};
+      for (unsigned t : to) {
+        if (t != from) {
+          edges.insert(std::make_pair(from, t));
+        }
+      }
+    }
+  }
+  return edges;
+}
+
+Lifeform MakeLifeform(uint64_t id) {
+  return std::make_shared<LifeformImpl>(id, 0, true, 10.0, Coord(0, 0), Dna(4));
+}
+
+std::vector<uint64_t> Ids(const std::vector<Lifeform> & lifeforms) {
+  std::vector<uint64_t> ids;
+  for (auto & lf : lifeforms) {
+    ids.push_back(lf->Id());
+  }
+  return ids;
+}
+
+}  // namespace anon
+
+
+TEST(AsteroidTest, All) {
+  for (unsigned n : kEngineCounts) {
+    Asteroid asteroid(MakeConfig("all"), n, 1);
+    EdgeSet expected;
+    for (unsigned from = 0; from < n; ++from) {
+      for (unsigned to = 0; to < n; ++to) {
+        if (from != to) {
+          expected.insert(std::make_pair(from, to));
+        }
+      }
+    }
+    EdgeSet edges = Edges(asteroid);
+    EXPECT_EQ(expected, edges) << n << " engines";
+    ExpectDegrees(edges, n, n - 1);
+  }
+}
+
+
+TEST(AsteroidTest, Ring) {
+  for (unsigned n : kEngineCounts) {
+    Asteroid asteroid(MakeConfig("ring"), n, 1);
+    EdgeSet expected;
+    for (unsigned from = 0; n > 1 && from < n; ++from) {
+      expected.insert(std::make_pair(from, (from + 1) % n));
+    }
+    EdgeSet edges = Edges(asteroid);
+    EXPECT_EQ(expected, edges) << n << " engines";
+    ExpectDegrees(edges, n, n > 1 ? 1 : 0);
+  }
+}
+
+
+TEST(AsteroidTest, TorusGridShape) {
+  // As square a grid as the count allows; primes make a single column
+  struct {
+    unsigned n, rows, cols, degree;
+  } shapes[] = {
+    {1, 1, 1, 0},    // nobody to talk to
+    {2, 2, 1, 1},    // up and down are the same engine
+    {3, 3, 1, 2},
+    {5, 5, 1, 2},
+    {16, 4, 4, 4},
+    {12, 4, 3, 4},
+    {4, 2, 2, 2},    // left is right, up is down
+  };
+  for (auto & s : shapes) {
+    Asteroid asteroid(MakeConfig("torus"), s.n, 1);
+    EdgeSet edges = Edges(asteroid);
+    EXPECT_EQ(TorusEdges(s.rows, s.cols), edges) << s.n << " engines";
+    ExpectDegrees(edges, s.n, s.degree);
+  }
+
+  // Engine 5 is at (1, 1) of the 4x4 grid; engine 0's neighbours wrap
+  Asteroid asteroid(MakeConfig("torus"), 16, 1);
+  EdgeSet edges = Edges(asteroid);
+  for (unsigned to : {4, 6, 1, 9}) {
+    EXPECT_EQ(1u, edges.count(std::make_pair(5u, to))) << "5 -> " << to;
+  }
+  for (unsigned to : {1, 3, 4, 12}) {
+    EXPECT_EQ(1u, edges.count(std::make_pair(0u, to))) << "0 -> " << to;
+  }
+}
+
+
+TEST(AsteroidTest, Random) {
+  for (unsigned n : kEngineCounts) {
+    for (int degree : {1, 2, 3}) {
+      for (uint64_t seed = 1; seed <= 20; ++seed) {
+        Config config = MakeConfig("random");
+        config.migration_degree = degree;
+        Asteroid asteroid(config, n, seed);
+        // The steps round the circle are distinct, so no edge is dropped as a
+        // repeat and every engine keeps its full degree both ways
+        EdgeSet edges = Edges(asteroid);
+        unsigned expected_degree = std::min<unsigned>(degree, n - 1);
+        EXPECT_EQ(n * expected_degree, edges.size()) << n << " engines, seed " << seed;
+        ExpectDegrees(edges, n, expected_degree);
+      }
+    }
+  }
+}
+
+
+TEST(AsteroidTest, RandomIsSeeded) {
+  Config config = MakeConfig("random");
+  config.migration_degree = 2;
+  EXPECT_EQ(Edges(Asteroid(config, 16, 42)), Edges(Asteroid(config, 16, 42)));
+
+  // Some other seed gives a different graph
+  bool differs = false;
+  for (uint64_t seed = 43; seed < 53 && !differs; ++seed) {
+    differs = Edges(Asteroid(config, 16, 42)) != Edges(Asteroid(config, 16, seed));
+  }
+  EXPECT_TRUE(differs);
+}
+
+
+TEST(AsteroidTest, RandomWithDegreeOfAtLeastEveryEngineIsAll) {
+  for (unsigned n : kEngineCounts) {
+    for (int degree : {int(n) - 1, int(n), int(n) + 7}) {
+      if (degree < 1) {
+        continue;
+      }
+      Config config = MakeConfig("random");
+      config.migration_degree = degree;
+      EXPECT_EQ(Edges(Asteroid(MakeConfig("all"), n, 1)), Edges(Asteroid(config, n, 3)))
+          << n << " engines, degree " << degree;
+    }
+  }
+}
+
+
+TEST(AsteroidTest, LaunchEvictsOldestFromFullEdge) {
+  Config config = MakeConfig("ring");
+  config.asteroid_size = 2;
+  config.migration_batch = 10;
+  config.asteroid_evict_on_full = true;
+  Asteroid asteroid(config, 2, 1);
+
+  std::vector<Lifeform> migrants = {MakeLifeform(1), MakeLifeform(2), MakeLifeform(3)};
+  asteroid.Launch(0, migrants);
+  EXPECT_TRUE(migrants.empty());
+
+  const Asteroid::Edge & edge = asteroid.GetEdge(0);
+  ASSERT_EQ(0u, edge.from);
+  EXPECT_EQ(3u, edge.launched.load());
+  EXPECT_EQ(1u, edge.evicted.load());
+  EXPECT_EQ(0u, edge.turned_away.load());
+
+  std::vector<Lifeform> landed;
+  asteroid.Land(1, landed);
+  EXPECT_EQ(std::vector<uint64_t>({2, 3}), Ids(landed));
+  EXPECT_EQ(2u, edge.landed.load());
+}
+
+
+TEST(AsteroidTest, LaunchTurnsAwayFromFullEdge) {
+  Config config = MakeConfig("ring");
+  config.asteroid_size = 2;
+  config.migration_batch = 10;
+  config.asteroid_evict_on_full = false;
+  Asteroid asteroid(config, 2, 1);
+
+  std::vector<Lifeform> migrants = {MakeLifeform(1), MakeLifeform(2), MakeLifeform(3)};
+  asteroid.Launch(0, migrants);
+  EXPECT_EQ(std::vector<uint64_t>({3}), Ids(migrants));
+
+  const Asteroid::Edge & edge = asteroid.GetEdge(0);
+  EXPECT_EQ(2u, edge.launched.load());
+  EXPECT_EQ(0u, edge.evicted.load());
+  EXPECT_EQ(1u, edge.turned_away.load());
+
+  std::vector<Lifeform> landed;
+  asteroid.Land(1, landed);
+  EXPECT_EQ(std::vector<uint64_t>({1, 2}), Ids(landed));
+}
+
+
+TEST(AsteroidTest, LaunchWithNowhereToGo) {
+  Asteroid asteroid(MakeConfig("all"), 1, 1);
+  std::vector<Lifeform> migrants = {MakeLifeform(1)};
+  asteroid.Launch(0, migrants);
+  EXPECT_EQ(std::vector<uint64_t>({1}), Ids(migrants));
+}
@@ -0,0 +1,89 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+TEST(BoundedQueueTest, FirstInFirstOut) {
+  BoundedQueue<int> q(3);
+  int v = -1;
+  EXPECT_FALSE(q.TryPop(&v));
+
+  // Go round the ring a few times
+  for (int lap = 0; lap < 4; ++lap) {
+    EXPECT_TRUE(q.TryPush(lap * 10 + 1));
+    EXPECT_TRUE(q.TryPush(lap * 10 + 2));
+    EXPECT_TRUE(q.TryPush(lap * 10 + 3));
+    EXPECT_FALSE(q.TryPush(99));
+    EXPECT_EQ(3u, q.SizeApprox());
+    for (int i = 1; i <= 3; ++i) {
+      EXPECT_TRUE(q.TryPop(&v));
+      EXPECT_EQ(lap * 10 + i, v);
+    }
+    EXPECT_FALSE(q.TryPop(&v));
+    EXPECT_EQ(0u, q.SizeApprox());
+  }
+}
+
+
+TEST(BoundedQueueTest, FailedPushKeepsValue) {
+  BoundedQueue<std::vector<int>> q(1);
+  EXPECT_TRUE(q.TryPush(std::vector<int>{1}));
+  std::vector<int> v {2, 3};
+  EXPECT_FALSE(q.TryPush(std::move(v)));
+  EXPECT_EQ(2u, v.size());
+}
+
+
+TEST(BoundedQueueTest, ManyProducersAndConsumers) {
+  const int kThreads = 4;
+  const uint32_t kPerThread = 20000;
+  BoundedQueue<uint32_t> q(16);
+  std::atomic<uint64_t> popped_sum(0);
+  std::atomic<uint32_t> popped(0);
+
+  // Every value is pushed once and popped once, whatever the interleaving
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (uint32_t i = 1; i <= kPerThread; ++i) {
+        while (!q.TryPush(t * kPerThread + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      uint32_t v;
+      while (popped.load() < kThreads * kPerThread) {
+        if (q.TryPop(&v)) {
+          popped_sum += v;
+          ++popped;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  const uint64_t n = kThreads * kPerThread;
+  EXPECT_EQ(n, popped.load());
+  EXPECT_EQ(n * (n + 1) / 2, popped_sum.load());
+  EXPECT_EQ(0u, q.SizeApprox());
+}
@@ -0,0 +1,126 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Arena.h"
+#include "BufferedWriter.h"
+#include "Checkpoint.h"
+#include "Coord.h"
+#include "Dna.h"
+#include "Types.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+std::string TempFilename() {
+  return "/tmp/evol-checkpoint-test-" + std::to_string(getpid());
+}
+
+CheckpointHeader MakeHeader() {
+  CheckpointHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+  header.byte_order = kCheckpointByteOrder;
+  header.version = kCheckpointVersion;
+  header.num_engines = 1;
+  return header;
+}
+
+void AddLifeform(Arena & arena, uint64_t gen, const Dna & dna, float energy, const Coord & c) {
+  arena.AddLifeform(gen, arena.Genomes().Intern(dna), energy, c);
+}
+
+}  // namespace anon
+
+
+TEST(CheckpointTest, ArenaRoundTrip) {
+  Coord::SetGlobalBounds(8, 5);
+  Arena arena(8, 5);
+  arena.SetIdSequence(2, 3);
+  const Dna crowded {OpCode::IS_CROWDED, OpCode::CJMP1, OpCode::FINAL_MOVE_EAST};
+  AddLifeform(arena, 0, Dna{OpCode::FINAL_MOVE_RANDOM}, 1.0f, Coord(1, 1));
+  AddLifeform(arena, 3, crowded, 2.5f, Coord(1, 1));
+  AddLifeform(arena, 1, Dna{}, 0.25f, Coord(7, 4));
+  AddLifeform(arena, 2, crowded, 9.0f, Coord(1, 1));
+  // Shuffle the occupant list of (1, 1) out of store order
+  arena.MoveLifeform(0, Coord(1, 1));
+
+  const std::string filename = TempFilename();
+  ASSERT_TRUE(WriteFileAtomically(filename, [&](BufferedWriter & buffer) {
+    CheckpointWriter out(buffer);
+    out.Put(MakeHeader());
+    arena.SaveCheckpoint(out);
+  }));
+
+  CheckpointReader in;
+  ASSERT_TRUE(in.Open(filename));
+  Arena restored(8, 5);
+  ASSERT_TRUE(restored.RestoreCheckpoint(in));
+  EXPECT_TRUE(in.Done());
+  remove(filename.c_str());
+
+  const LifeformStore & a = arena.Lifeforms();
+  const LifeformStore & b = restored.Lifeforms();
+  ASSERT_EQ(a.Size(), b.Size());
+  for (LifeformIndex lf = 0; lf < a.Size(); ++lf) {
+    EXPECT_EQ(a.Id(lf), b.Id(lf));
+    EXPECT_EQ(a.Gen(lf), b.Gen(lf));
+    EXPECT_EQ(a.GetEnergy(lf), b.GetEnergy(lf));
+    EXPECT_TRUE(a.GetCoord(lf) == b.GetCoord(lf));
+    EXPECT_TRUE(a.GetDna(lf) == b.GetDna(lf));
+    EXPECT_EQ(a.GetTable(lf).Sensors(), b.GetTable(lf).Sensors());
+  }
+  for (Unit y = 0; y < 5; ++y) {
+    for (Unit x = 0; x < 8; ++x) {
+      Span<const LifeformIndex> expected = arena.LifeformsAt(Coord(x, y));
+      Span<const LifeformIndex> got = restored.LifeformsAt(Coord(x, y));
+      ASSERT_EQ(expected.size(), got.size());
+      for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], got[i]);
+      }
+      EXPECT_EQ(arena.OccupancyPlane()[arena.CellIndex(Coord(x, y))],
+                restored.OccupancyPlane()[restored.CellIndex(Coord(x, y))]);
+    }
+  }
+
+  // Both carry on issuing the same ids
+  AddLifeform(arena, 0, Dna{}, 1.0f, Coord(0, 0));
+  AddLifeform(restored, 0, Dna{}, 1.0f, Coord(0, 0));
+  EXPECT_EQ(arena.Lifeforms().Id(4), restored.Lifeforms().Id(4));
+}
+
+
+TEST(CheckpointTest, RejectsTruncated) {
+  Coord::SetGlobalBounds(4, 4);
+  Arena arena(4, 4);
+  AddLifeform(arena, 0, Dna{OpCode::FINAL_MOVE_NORTH}, 1.0f, Coord(2, 3));
+
+  const std::string filename = TempFilename();
+  ASSERT_TRUE(WriteFileAtomically(filename, [&](BufferedWriter & buffer) {
+    CheckpointWriter out(buffer);
+    out.Put(MakeHeader());
+    arena.SaveCheckpoint(out);
+  }));
+  ASSERT_EQ(0, truncate(filename.c_str(), sizeof(CheckpointHeader) + 40));
+
+  CheckpointReader in;
+  ASSERT_TRUE(in.Open(filename));
+  Arena restored(4, 4);
+  EXPECT_FALSE(restored.RestoreCheckpoint(in));
+  EXPECT_FALSE(in.Ok());
+  remove(filename.c_str());
+}
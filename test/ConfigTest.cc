@@ -0,0 +1,158 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <cstdint>
+#include <string>
+
+#include "Config.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+TEST(ConfigTest, SetParsesEachType) {
+  Config config;
+  EXPECT_TRUE(config.Set("width", "300"));
+  EXPECT_TRUE(config.Set(" height = 200 "));
+  EXPECT_TRUE(config.Set("lifeform_asteroid_launch_interval=18446744073709551615"));
+  EXPECT_TRUE(config.Set("asteroid_evict_on_full", "false"));
+  EXPECT_TRUE(config.Set("cost_of_living", "0.25"));
+  EXPECT_TRUE(config.Set("migration_topology", "torus"));
+  EXPECT_EQ(300, config.width);
+  EXPECT_EQ(200, config.height);
+  EXPECT_EQ(UINT64_MAX, config.lifeform_asteroid_launch_interval);
+  EXPECT_FALSE(config.asteroid_evict_on_full);
+  EXPECT_EQ(0.25f, config.cost_of_living);
+  EXPECT_EQ("torus", config.migration_topology);
+}
+
+
+TEST(ConfigTest, SetRejectsBadValues) {
+  Config config;
+  testing::internal::CaptureStderr();
+  EXPECT_FALSE(config.Set("no_such_setting", "1"));
+  EXPECT_FALSE(config.Set("width"));
+  EXPECT_FALSE(config.Set("width", ""));
+  EXPECT_FALSE(config.Set("width", "12x"));
+  EXPECT_FALSE(config.Set("width", "4294967296"));
+  EXPECT_FALSE(config.Set("lifeform_asteroid_land_interval", "-1"));
+  EXPECT_FALSE(config.Set("asteroid_evict_on_full", "yes"));
+  EXPECT_FALSE(config.Set("cost_of_living", "cheap"));
+  // Integers are decimal: no octal or hex
+  EXPECT_FALSE(config.Set("width", "0x40"));
+  EXPECT_FALSE(config.Set("lifeform_asteroid_land_interval", "0x40"));
+  testing::internal::GetCapturedStderr();
+
+  EXPECT_EQ(Config().width, config.width);
+  EXPECT_TRUE(config.Set("width", "010"));
+  EXPECT_EQ(10, config.width);
+  EXPECT_TRUE(config.Set("lifeform_asteroid_land_interval", "010"));
+  EXPECT_EQ(10u, config.lifeform_asteroid_land_interval);
+}
+
+
+TEST(ConfigTest, LoadStringSkipsCommentsAndBlankLines) {
+  Config config;
+  EXPECT_TRUE(config.LoadString("# A comment\n"
+                                "\n"
+                                "   \t\n"
+                                "width = 64  # trailing comment\n"
+                                "height=32\n"
+                                "num_engines = 3", "test"));
+  EXPECT_EQ(64, config.width);
+  EXPECT_EQ(32, config.height);
+  EXPECT_EQ(3, config.num_engines);
+}
+
+
+TEST(ConfigTest, LoadStringReportsBadLine) {
+  Config config;
+  testing::internal::CaptureStderr();
+  EXPECT_FALSE(config.LoadString("width = 64\n"
+                                 "# fine\n"
+                                 "\n"
+                                 "height = tall\n"
+                                 "num_engines = 3\n", "settings.conf"));
+  std::string err = testing::internal::GetCapturedStderr();
+  EXPECT_NE(std::string::npos, err.find("settings.conf:4")) << err;
+  // Settings up to the bad line were applied, the rest weren't
+  EXPECT_EQ(64, config.width);
+  EXPECT_EQ(Config().num_engines, config.num_engines);
+}
+
+
+TEST(ConfigTest, Validate) {
+  testing::internal::CaptureStderr();
+  EXPECT_TRUE(Config().Validate());
+
+  Config config;
+  config.width = 0;
+  EXPECT_FALSE(config.Validate());
+
+  config = Config();
+  config.migration_topology = "star";
+  EXPECT_FALSE(config.Validate());
+
+  config = Config();
+  config.dump_format = "xml";
+  EXPECT_FALSE(config.Validate());
+
+  config = Config();
+  config.max_mutation_length = 0;
+  EXPECT_FALSE(config.Validate());
+
+  // Thresholds a d(mutation_die_roll + 1) roll could never reach, or in the
+  // wrong order, would quietly switch mutation off
+  config = Config();
+  config.one_mutation = config.two_mutations + 1;
+  EXPECT_FALSE(config.Validate());
+
+  config = Config();
+  config.one_mutation = config.mutation_die_roll + 1;
+  config.two_mutations = config.mutation_die_roll + 1;
+  EXPECT_FALSE(config.Validate());
+
+  config = Config();
+  config.two_mutations = config.mutation_die_roll + 1;
+  EXPECT_FALSE(config.Validate());
+
+  config = Config();
+  config.one_mutation = config.mutation_die_roll;
+  config.two_mutations = config.mutation_die_roll;
+  EXPECT_TRUE(config.Validate());
+  testing::internal::GetCapturedStderr();
+}
+
+
+TEST(ConfigTest, ToStringRoundTrips) {
+  // Checkpoints carry their settings this way, so every value must survive
+  Config config;
+  config.num_engines = 5;
+  config.width = 777;
+  config.lifeform_asteroid_launch_interval = UINT64_MAX - 1;
+  config.asteroid_evict_on_full = !config.asteroid_evict_on_full;
+  config.cost_of_living = 0.1f;
+  config.meiosis_level = 1.0f / 3.0f;
+  config.random_move_cost = 1e-7f;
+  config.migration_topology = "random";
+  config.checkpoint_filename = "/tmp/some file.ckpt";
+
+  Config loaded;
+  ASSERT_TRUE(loaded.LoadString(config.ToString(), "round trip"));
+  EXPECT_EQ(config.ToString(), loaded.ToString());
+  EXPECT_EQ(config.num_engines, loaded.num_engines);
+  EXPECT_EQ(config.width, loaded.width);
+  EXPECT_EQ(config.lifeform_asteroid_launch_interval, loaded.lifeform_asteroid_launch_interval);
+  EXPECT_EQ(config.asteroid_evict_on_full, loaded.asteroid_evict_on_full);
+  EXPECT_EQ(config.cost_of_living, loaded.cost_of_living);
+  EXPECT_EQ(config.meiosis_level, loaded.meiosis_level);
+  EXPECT_EQ(config.random_move_cost, loaded.random_move_cost);
+  EXPECT_EQ(config.migration_topology, loaded.migration_topology);
+  EXPECT_EQ(config.checkpoint_filename, loaded.checkpoint_filename);
+}
@@ -69,6 +69,29 @@ TEST_F(CoordTest, WrapsMaxValues) {
 }
 
 
+TEST_F(CoordTest, WrapsMultiplesOfBounds) {
+  Coord ca(-kMaxWidth, -kMaxHeight);
+  EXPECT_EQ(0, ca.x);
+  EXPECT_EQ(0, ca.y);
+
+  Coord cb(3 * kMaxWidth + 2, -2 * kMaxHeight - 1);
+  EXPECT_EQ(2, cb.x);
+  EXPECT_EQ(kMaxHeight - 1, cb.y);
+}
+
+
+TEST_F(CoordTest, WrapsEachAxisByItsOwnBound) {
+  // Wider than tall, so y values between the two bounds must still wrap
+  Coord::SetGlobalBounds(kMaxHeight, kMaxWidth);
+
+  Coord c(kMaxWidth, kMaxWidth);
+  EXPECT_EQ(kMaxWidth, c.x);
+  EXPECT_EQ(0, c.y);
+
+  Coord::SetGlobalBounds(kMaxWidth, kMaxHeight);
+}
+
+
 TEST_F(CoordTest, Directions) {
   Coord c;
 
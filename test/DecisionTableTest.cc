@@ -0,0 +1,115 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <cstdint>
+
+#include "DecisionTable.h"
+#include "Dna.h"
+#include "Random.h"
+#include "Types.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+TEST(DecisionTableTest, EmptyDnaDies) {
+  DecisionTable t(Dna{});
+
+  EXPECT_EQ(0, t.Sensors());
+  for (unsigned state = 0; state < kNumSensorStates; ++state) {
+    EXPECT_EQ(ActionType::APOPTOSIS, t.Lookup(state));
+  }
+}
+
+
+TEST(DecisionTableTest, FallsOffEnd) {
+  DecisionTable t(Dna{OpCode::NOP, OpCode::JMP1, OpCode::FINAL_MOVE_NORTH});
+
+  EXPECT_EQ(0, t.Sensors());
+  EXPECT_EQ(ActionType::NOTHING, t.Lookup(0));
+  EXPECT_EQ(ActionType::NOTHING, t.Lookup(kNumSensorStates - 1));
+}
+
+
+TEST(DecisionTableTest, RandomMoveIsLeftToCaller) {
+  DecisionTable t(Dna{OpCode::FINAL_MOVE_RANDOM});
+
+  EXPECT_EQ(ActionType::MOVE_RANDOM, t.Lookup(0));
+}
+
+
+TEST(DecisionTableTest, ConditionalJump) {
+  // Flee south if someone is to the north, otherwise go north
+  DecisionTable t(Dna{
+    OpCode::IS_NORTH_OCCUPIED,
+    OpCode::CJMP1,
+    OpCode::FINAL_MOVE_NORTH,
+    OpCode::FINAL_MOVE_SOUTH,
+  });
+
+  EXPECT_EQ(kSensorNorth, t.Sensors());
+  EXPECT_EQ(ActionType::MOVE_NORTH, t.Lookup(0));
+  EXPECT_EQ(ActionType::MOVE_SOUTH, t.Lookup(kSensorNorth));
+  // Untested sensors don't matter
+  EXPECT_EQ(ActionType::MOVE_NORTH, t.Lookup(kSensorSouth | kSensorCrowded));
+  EXPECT_EQ(ActionType::MOVE_SOUTH, t.Lookup(kSensorNorth | kSensorNeighbor));
+}
+
+
+TEST(DecisionTableTest, LastCompareWins) {
+  DecisionTable t(Dna{
+    OpCode::IS_CROWDED,
+    OpCode::IS_NEIGHBOR,
+    OpCode::CJMP2,
+    OpCode::APOPTOSIS,
+    OpCode::NOP,
+    OpCode::FINAL_MOVE_WEST,
+  });
+
+  EXPECT_EQ(kSensorCrowded | kSensorNeighbor, t.Sensors());
+  EXPECT_EQ(ActionType::APOPTOSIS, t.Lookup(0));
+  EXPECT_EQ(ActionType::APOPTOSIS, t.Lookup(kSensorCrowded));
+  EXPECT_EQ(ActionType::MOVE_WEST, t.Lookup(kSensorNeighbor));
+}
+
+
+TEST(DecisionTableTest, MatchesInterpreter) {
+  // A jumble of every opcode; the table must agree with direct evaluation in
+  // every state
+  Dna dna;
+  for (int i = 0; i < 3; ++i) {
+    for (int32_t op = kOpcodeBegin; op <= kOpcodeEnd; ++op) {
+      OpCode oc = static_cast<OpCode>(op);
+      if (oc == OpCode::APOPTOSIS || oc == OpCode::FINAL_MOVE_RANDOM)
+        continue;
+      dna.push_back(oc);
+    }
+  }
+  DecisionTable t(dna);
+
+  for (unsigned state = 0; state < kNumSensorStates; ++state) {
+    EXPECT_EQ(DecisionTable::Evaluate(dna, state), t.Lookup(state));
+  }
+}
+
+
+TEST(DecisionTableTest, MatchesInterpreterOnRandomDna) {
+  Xoshiro256 rng(2018);
+  for (int trial = 0; trial < 2000; ++trial) {
+    Dna dna(rng.Bounded(40));
+    for (auto & opcode : dna) {
+      opcode = static_cast<OpCode>(rng.Bounded(kOpcodeEnd + 1));
+    }
+
+    DecisionTable t(dna);
+    for (unsigned state = 0; state < kNumSensorStates; ++state) {
+      ASSERT_EQ(DecisionTable::Evaluate(dna, state), t.Lookup(state)) << "trial " << trial;
+    }
+  }
+}
@@ -0,0 +1,124 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Dna.h"
+#include "Span.h"
+#include "Types.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+const size_t kInline = Dna::kInlineCapacity;
+
+
+/**
+ * Opcode i of a recognizable test pattern.
+ */
+OpCode Pattern(size_t i) {
+  return static_cast<OpCode>(i % (kOpcodeEnd + 1));
+}
+
+
+/**
+ * Dna and std::vector holding the same opcodes.
+ */
+void ExpectSame(const std::vector<OpCode> & expected, const Dna & dna) {
+  ASSERT_EQ(expected.size(), dna.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], dna[i]) << "at " << i;
+  }
+}
+
+}  // namespace anon
+
+
+TEST(DnaTest, GrowsOutOfInlineStorage) {
+  Dna dna;
+  std::vector<OpCode> expected;
+  EXPECT_TRUE(dna.empty());
+  EXPECT_EQ(kInline, dna.capacity());
+
+  for (size_t i = 0; i < 5 * kInline; ++i) {
+    dna.push_back(Pattern(i));
+    expected.push_back(Pattern(i));
+    if (i < kInline) {
+      EXPECT_EQ(kInline, dna.capacity());
+    }
+  }
+  EXPECT_LT(kInline, dna.capacity());
+  ExpectSame(expected, dna);
+
+  dna.resize(kInline + 3);
+  expected.resize(kInline + 3);
+  ExpectSame(expected, dna);
+  dna.resize(2 * kInline);
+  expected.resize(2 * kInline, OpCode::NOP);
+  ExpectSame(expected, dna);
+}
+
+
+TEST(DnaTest, InsertAndErase) {
+  // Around the edge of inline storage, and well past it
+  for (size_t size : {size_t{0}, kInline - 2, kInline, 3 * kInline}) {
+    for (size_t at = 0; at <= size; at += (size / 4) + 1) {
+      Dna dna;
+      std::vector<OpCode> expected;
+      for (size_t i = 0; i < size; ++i) {
+        dna.push_back(Pattern(i));
+        expected.push_back(Pattern(i));
+      }
+
+      dna.insert(dna.begin() + at, 3, OpCode::JMP4);
+      expected.insert(expected.begin() + at, 3, OpCode::JMP4);
+      ExpectSame(expected, dna);
+
+      dna.erase(dna.begin() + at / 2, dna.begin() + at + 2);
+      expected.erase(expected.begin() + at / 2, expected.begin() + at + 2);
+      ExpectSame(expected, dna);
+    }
+  }
+}
+
+
+TEST(DnaTest, CopyMoveAndCompare) {
+  const Dna small {OpCode::IS_CROWDED, OpCode::CJMP1, OpCode::FINAL_MOVE_EAST};
+  Dna big(3 * kInline);
+  big[kInline] = OpCode::APOPTOSIS;
+
+  Dna a(small), b(big);
+  EXPECT_EQ(small, a);
+  EXPECT_EQ(big, b);
+  EXPECT_NE(a, b);
+
+  // Assigning either way across the inline/heap boundary
+  a = big;
+  b = small;
+  EXPECT_EQ(big, a);
+  EXPECT_EQ(small, b);
+
+  Dna c(std::move(a));
+  EXPECT_EQ(big, c);
+  EXPECT_TRUE(a.empty());
+  a = std::move(b);
+  EXPECT_EQ(small, a);
+  a = std::move(c);
+  EXPECT_EQ(big, a);
+
+  Span<const OpCode> view = a;
+  EXPECT_EQ(a.data(), view.data());
+  EXPECT_EQ(a.size(), view.size());
+  EXPECT_EQ(small, Dna(small.begin(), small.end()));
+}
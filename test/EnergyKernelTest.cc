@@ -0,0 +1,179 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "EnergyKernel.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+const EnergyKernel::Isa kIsas[] = {EnergyKernel::Isa::SSE41, EnergyKernel::Isa::AVX2};
+
+/**
+ * Random energy and occupancy planes.  Occupancy is mostly 0 with the odd
+ * crowded square, like a real arena.
+ */
+void MakePlanes(int width, int height, unsigned seed,
+                std::vector<float> & energy, std::vector<uint32_t> & occupancy) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> e(0.0, 20.0);
+  std::uniform_int_distribution<uint32_t> o(0, 9);
+  energy.resize(width * height);
+  occupancy.resize(width * height);
+  for (int i = 0; i < width * height; ++i) {
+    energy[i] = e(gen);
+    uint32_t roll = o(gen);
+    occupancy[i] = roll < 6 ? 0 : roll - 5;
+  }
+}
+
+void ExpectGainsMatchScalar(int width, int height) {
+  std::vector<float> energy;
+  std::vector<uint32_t> occupancy;
+  MakePlanes(width, height, width * 31 + height, energy, occupancy);
+
+  std::vector<float> shares(width * height), expected(width * height);
+  EnergyKernel(EnergyKernel::Isa::SCALAR).ComputeGains(
+      width, height, energy.data(), occupancy.data(), shares.data(), expected.data());
+
+  for (auto isa : kIsas) {
+    if (!EnergyKernel::Supported(isa)) {
+      continue;
+    }
+    std::vector<float> gains(width * height, -1.0);
+    EnergyKernel(isa).ComputeGains(
+        width, height, energy.data(), occupancy.data(), shares.data(), gains.data());
+    for (int i = 0; i < width * height; ++i) {
+      EXPECT_EQ(expected[i], gains[i])
+          << EnergyKernel::IsaName(isa) << " " << width << "x" << height << " @" << i;
+    }
+  }
+}
+
+}  // namespace anon
+
+
+TEST(EnergyKernelTest, ScalarIsAlwaysSupported) {
+  EXPECT_TRUE(EnergyKernel::Supported(EnergyKernel::Isa::SCALAR));
+  EXPECT_TRUE(EnergyKernel::Supported(EnergyKernel::BestIsa()));
+  EXPECT_EQ(EnergyKernel::BestIsa(), EnergyKernel().GetIsa());
+}
+
+
+TEST(EnergyKernelTest, ScalarGains) {
+  // 3x3 arena, one lifeform in the middle and two in the corner
+  std::vector<float> energy(9, 10.0);
+  std::vector<uint32_t> occupancy {2, 0, 0,
+                                   0, 1, 0,
+                                   0, 0, 0};
+  std::vector<float> shares(9), gains(9);
+  EnergyKernel(EnergyKernel::Isa::SCALAR).ComputeGains(
+      3, 3, energy.data(), occupancy.data(), shares.data(), gains.data());
+
+  // Every empty square is adjacent to both occupied ones (the arena wraps), so
+  // each gives a third of its energy to each lifeform, fractions and all.
+  // Occupied squares offer nothing.
+  EXPECT_FLOAT_EQ(0.0, shares[0]);
+  EXPECT_FLOAT_EQ(0.0, shares[4]);
+  EXPECT_FLOAT_EQ(10.0 / 3.0, shares[1]);
+  EXPECT_FLOAT_EQ(10.0 / 2.0 + 7 * 10.0 / 3.0, gains[0]);
+  EXPECT_FLOAT_EQ(10.0 + 7 * 10.0 / 3.0, gains[4]);
+  EXPECT_FLOAT_EQ(0.0, gains[1]);
+}
+
+
+TEST(EnergyKernelTest, GainsMatchScalar) {
+  ExpectGainsMatchScalar(64, 64);
+  ExpectGainsMatchScalar(100, 37);
+  ExpectGainsMatchScalar(37, 100);
+}
+
+
+TEST(EnergyKernelTest, GainsMatchScalarOnOddShapes) {
+  // Narrower than a vector, or one vector plus a ragged tail
+  for (int width = 1; width <= 20; ++width) {
+    ExpectGainsMatchScalar(width, 5);
+  }
+  // Single rows and columns wrap onto themselves
+  ExpectGainsMatchScalar(33, 1);
+  ExpectGainsMatchScalar(1, 33);
+}
+
+
+TEST(EnergyKernelTest, StripsMatchWholeArena) {
+  const int width = 40, height = 23;
+  std::vector<float> energy;
+  std::vector<uint32_t> occupancy;
+  MakePlanes(width, height, 5, energy, occupancy);
+
+  std::vector<float> shares(width * height), expected(width * height);
+  EnergyKernel kernel;
+  kernel.ComputeGains(width, height, energy.data(), occupancy.data(), shares.data(), expected.data());
+
+  // Uneven strips, including single rows at the wrapped top and bottom edges
+  const int rows[] = {0, 1, 8, 9, 22, 23};
+  std::vector<float> strip_shares(width * height, -1.0), gains(width * height, -1.0);
+  for (size_t s = 0; s + 1 < sizeof(rows) / sizeof(rows[0]); ++s) {
+    kernel.ComputeShares(width, height, rows[s], rows[s + 1], energy.data(), occupancy.data(),
+                         strip_shares.data());
+  }
+  for (size_t s = 0; s + 1 < sizeof(rows) / sizeof(rows[0]); ++s) {
+    kernel.ComputeGains(width, height, rows[s], rows[s + 1], energy.data(), occupancy.data(),
+                        strip_shares.data(), gains.data());
+  }
+  for (int i = 0; i < width * height; ++i) {
+    EXPECT_EQ(shares[i], strip_shares[i]) << "@" << i;
+    EXPECT_EQ(expected[i], gains[i]) << "@" << i;
+  }
+}
+
+
+TEST(EnergyKernelTest, ApplyGainsMatchesScalar) {
+  const int cells = 50;
+  std::vector<float> gains(cells);
+  for (int i = 0; i < cells; ++i) {
+    gains[i] = i * 0.25;
+  }
+
+  // Sizes that leave a tail for every vector width
+  for (size_t n = 0; n <= 19; ++n) {
+    std::vector<uint32_t> cell(n), dna_size(n);
+    std::vector<float> expected(n);
+    for (size_t i = 0; i < n; ++i) {
+      cell[i] = (i * 7) % cells;
+      dna_size[i] = i * 3 + 1;
+      expected[i] = 1.0 + i;
+    }
+    std::vector<float> start(expected);
+    EnergyKernel(EnergyKernel::Isa::SCALAR).ApplyGains(
+        n, cell.data(), dna_size.data(), gains.data(), 0.5, 0.01, expected.data());
+
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_FLOAT_EQ(start[i] + gains[cell[i]] - (0.5f + 0.01f * dna_size[i]), expected[i]);
+    }
+
+    for (auto isa : kIsas) {
+      if (!EnergyKernel::Supported(isa)) {
+        continue;
+      }
+      std::vector<float> energies(start);
+      EnergyKernel(isa).ApplyGains(
+          n, cell.data(), dna_size.data(), gains.data(), 0.5, 0.01, energies.data());
+      for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(expected[i], energies[i]) << EnergyKernel::IsaName(isa) << " @" << i;
+      }
+    }
+  }
+}
@@ -0,0 +1,90 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "Dna.h"
+#include "GenomeTable.h"
+#include "LifeformSnapshot.h"
+#include "Types.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+void AddLifeform(LifeformSnapshot & snapshot, uint64_t id, uint64_t gen, float energy,
+                 const Dna & dna) {
+  LifeformSnapshot::Record record = {id, gen, energy, true, 0, 0};
+  snapshot.Add(record, Span<const OpCode>(dna));
+}
+
+}  // namespace anon
+
+
+TEST(GenomeTableTest, HashDependsOnOrderAndLength) {
+  const Dna a {OpCode::IS_CROWDED, OpCode::FINAL_MOVE_EAST};
+  const Dna b {OpCode::FINAL_MOVE_EAST, OpCode::IS_CROWDED};
+  const Dna c {OpCode::IS_CROWDED, OpCode::FINAL_MOVE_EAST, OpCode::NOP};
+  EXPECT_EQ(HashDna(a), HashDna(Dna(a)));
+  EXPECT_NE(HashDna(a), HashDna(b));
+  EXPECT_NE(HashDna(a), HashDna(c));
+  EXPECT_NE(HashDna(Dna{}), HashDna(Dna{OpCode::NOP}));
+}
+
+
+TEST(GenomeTableTest, BuildAndMerge) {
+  const Dna random {OpCode::FINAL_MOVE_RANDOM};
+  const Dna crowded {OpCode::IS_CROWDED, OpCode::CJMP1, OpCode::APOPTOSIS};
+  const Dna empty {};
+
+  std::vector<LifeformSnapshot> snapshots(2);
+  AddLifeform(snapshots[0], 1, 4, 2.0f, random);
+  AddLifeform(snapshots[0], 2, 1, 1.0f, crowded);
+  AddLifeform(snapshots[0], 3, 6, 4.0f, random);
+  AddLifeform(snapshots[1], 4, 2, 3.0f, empty);
+  AddLifeform(snapshots[1], 5, 9, 8.0f, random);
+
+  std::vector<GenomeTable> tables(2);
+  tables[0].Build(snapshots[0]);
+  tables[1].Build(snapshots[1]);
+  ASSERT_EQ(2u, tables[0].Size());
+  EXPECT_EQ(0u, tables[0].RecordGenome(0));
+  EXPECT_EQ(1u, tables[0].RecordGenome(1));
+  EXPECT_EQ(0u, tables[0].RecordGenome(2));
+  EXPECT_EQ(2u, tables[0].Get(0).count);
+  EXPECT_EQ(4u, tables[0].Get(0).min_gen);
+  EXPECT_EQ(6u, tables[0].Get(0).max_gen);
+
+  GenomeTable all;
+  std::vector<uint32_t> remap0, remap1;
+  all.Merge(tables[0], &remap0);
+  all.Merge(tables[1], &remap1);
+
+  // Numbered by first appearance: random, crowded, empty
+  ASSERT_EQ(3u, all.Size());
+  EXPECT_EQ((std::vector<uint32_t>{0, 1}), remap0);
+  EXPECT_EQ((std::vector<uint32_t>{2, 0}), remap1);
+
+  const GenomeTable::Genome & g = all.Get(0);
+  EXPECT_EQ(HashDna(random), g.hash);
+  EXPECT_EQ(random.size(), g.dna.size());
+  EXPECT_EQ(OpCode::FINAL_MOVE_RANDOM, g.dna[0]);
+  EXPECT_EQ(3u, g.count);
+  EXPECT_EQ(4u, g.min_gen);
+  EXPECT_EQ(9u, g.max_gen);
+  EXPECT_FLOAT_EQ(2.0f, g.min_energy);
+  EXPECT_FLOAT_EQ(8.0f, g.max_energy);
+  EXPECT_DOUBLE_EQ(14.0, g.total_energy);
+
+  EXPECT_EQ(0u, all.Get(2).dna.size());
+  EXPECT_EQ(1u, all.Get(2).count);
+}
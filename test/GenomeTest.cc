@@ -0,0 +1,63 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <utility>
+
+#include "DecisionTable.h"
+#include "Dna.h"
+#include "Genome.h"
+#include "Types.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+TEST(GenomeTest, InternSharesEqualDna) {
+  GenomePool pool;
+  const Dna crowded {OpCode::IS_CROWDED, OpCode::CJMP1, OpCode::APOPTOSIS, OpCode::FINAL_MOVE_EAST};
+
+  GenomeRef a = pool.Intern(crowded);
+  GenomeRef b = pool.Intern(Dna(crowded));
+  GenomeRef c = pool.Intern(Dna{OpCode::FINAL_MOVE_RANDOM});
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_NE(a.get(), c.get());
+  EXPECT_EQ(2u, pool.Size());
+
+  EXPECT_EQ(crowded, a->GetDna());
+  EXPECT_EQ(HashDna(crowded), a->Hash());
+  DecisionTable table(crowded);
+  for (SensorBits state = 0; state < kNumSensorStates; ++state) {
+    EXPECT_EQ(table.Lookup(state), a->Table().Lookup(state));
+  }
+}
+
+
+TEST(GenomeTest, FreedWithLastReference) {
+  GenomePool pool;
+  const Dna dna {OpCode::FINAL_MOVE_NORTH};
+
+  GenomeRef a = pool.Intern(dna);
+  {
+    GenomeRef b = a;
+    GenomeRef c;
+    c = b;
+    a = GenomeRef();
+    EXPECT_EQ(1u, pool.Size());
+    GenomeRef d = std::move(c);
+    EXPECT_FALSE(c);
+    EXPECT_TRUE(d);
+  }
+  EXPECT_EQ(0u, pool.Size());
+
+  // A fresh genome can be made for the same Dna
+  a = pool.Intern(dna);
+  EXPECT_EQ(1u, pool.Size());
+  a = GenomeRef();
+  EXPECT_EQ(0u, pool.Size());
+}
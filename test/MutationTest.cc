@@ -0,0 +1,228 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Config.h"
+#include "Dna.h"
+#include "Mutation.h"
+#include "Random.h"
+#include "Types.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+/**
+ * Random Dna of the given size.
+ */
+Dna RandomDna(Xoshiro256 & rng, size_t size) {
+  Dna dna(size);
+  for (auto & opcode : dna) {
+    opcode = static_cast<OpCode>(kOpcodeBegin + rng.Bounded(kOpcodeEnd - kOpcodeBegin + 1));
+  }
+  return dna;
+}
+
+
+/**
+ * Pearson's chi-squared statistic of observed counts against expected ones.
+ */
+double ChiSquared(const std::vector<double> & observed, const std::vector<double> & expected) {
+  double chi2 = 0.0;
+  for (size_t i = 0; i < observed.size(); ++i) {
+    chi2 += (observed[i] - expected[i]) * (observed[i] - expected[i]) / expected[i];
+  }
+  return chi2;
+}
+
+
+/**
+ * Whether a chi-squared statistic is plausible for the given degrees of
+ * freedom: within six standard deviations of its mean.
+ */
+bool Plausible(double chi2, size_t dof) {
+  return chi2 < dof + 6.0 * std::sqrt(2.0 * dof);
+}
+
+
+/**
+ * The same translate done in place, as the mutation originally was: the
+ * source range takes the target's opcodes, then the target the source's.
+ */
+std::vector<OpCode> TranslateInPlace(const Dna & dna, const Mutation::Edit & edit) {
+  std::vector<OpCode> v(dna.begin(), dna.end());
+  std::vector<OpCode> tmp(v.begin() + edit.start, v.begin() + edit.start + edit.len);
+  for (int32_t i = 0; i < edit.len; ++i) {
+    v[edit.start + i] = v[edit.target + i];
+  }
+  for (int32_t i = 0; i < edit.len; ++i) {
+    v[edit.target + i] = tmp[i];
+  }
+  return v;
+}
+
+}  // namespace anon
+
+
+TEST(MutationTest, MatchesConfiguredOdds) {
+  Xoshiro256 rng(11);
+  ScopedGenerator sg(rng);
+  const Config config;
+  const int32_t kSize = 24;
+  const int kTrials = 200000;
+  const int32_t max_len = config.max_mutation_length;
+  const Dna dna = RandomDna(rng, kSize);
+  Mutation mutation;
+
+  // Mutations rolled; first mutation's (start, len), with (-1, -1) when
+  // nothing was done; and mutation types
+  std::vector<double> rolled(Mutation::kMaxMutations + 1);
+  std::map<std::pair<int32_t, int32_t>, double> first;
+  std::vector<double> types(4);
+  for (int i = 0; i < kTrials; ++i) {
+    const Dna * mutant = mutation.Mutate(dna, config);
+    Span<const Mutation::Edit> edits = mutation.Edits();
+    ASSERT_LE(edits.size(), size_t(mutation.Rolled()));
+    EXPECT_EQ(edits.empty(), mutant == nullptr);
+
+    rolled[mutation.Rolled()] += 1;
+    if (mutation.Rolled() > 0) {
+      first[edits.empty() ? std::make_pair(-1, -1) : std::make_pair(edits[0].start, edits[0].len)] += 1;
+    }
+    for (const Mutation::Edit & edit : edits) {
+      EXPECT_GE(edit.len, 1);
+      EXPECT_LE(edit.len, max_len);
+      types[static_cast<int>(edit.type)] += 1;
+    }
+  }
+
+  // The die: one mutation from one_mutation up, two from two_mutations up
+  const double faces = config.mutation_die_roll + 1;
+  std::vector<double> expected_rolled = {
+    kTrials * config.one_mutation / faces,
+    kTrials * (config.two_mutations - config.one_mutation) / faces,
+    kTrials * (faces - config.two_mutations) / faces,
+  };
+  EXPECT_TRUE(Plausible(ChiSquared(rolled, expected_rolled), 2));
+
+  // Start uniform in [0, size], then length uniform in [0, min(max_len,
+  // size - start)]; a zero length or start at the end does nothing
+  const double mutated = rolled[1] + rolled[2];
+  std::vector<double> observed, expected;
+  double nothing = 0.0;
+  for (int32_t start = 0; start <= kSize; ++start) {
+    const int32_t lens = std::min(max_len, kSize - start) + 1;
+    const double p = 1.0 / (kSize + 1) / lens;
+    for (int32_t len = 0; len < lens; ++len) {
+      if (len == 0 || start == kSize) {
+        nothing += p;
+        EXPECT_EQ(0u, first.count(std::make_pair(start, len)));
+      } else {
+        observed.push_back(first[std::make_pair(start, len)]);
+        expected.push_back(mutated * p);
+      }
+    }
+  }
+  observed.push_back(first[std::make_pair(-1, -1)]);
+  expected.push_back(mutated * nothing);
+  EXPECT_TRUE(Plausible(ChiSquared(observed, expected), observed.size() - 1));
+
+  // Each kind equally likely
+  const double edits = types[0] + types[1] + types[2] + types[3];
+  EXPECT_TRUE(Plausible(ChiSquared(types, std::vector<double>(4, edits / 4)), 3));
+}
+
+
+TEST(MutationTest, EditsMatchDescriptions) {
+  Xoshiro256 rng(12);
+  ScopedGenerator sg(rng);
+  // Always exactly one mutation
+  Config config;
+  config.one_mutation = 0;
+  config.two_mutations = config.mutation_die_roll + 1;
+  Mutation mutation;
+
+  int seen[4] = {};
+  for (int i = 0; i < 20000; ++i) {
+    // Sizes both sides of Dna's inline storage
+    const Dna dna = RandomDna(rng, rng.Bounded(3 * Dna::kInlineCapacity));
+    const Dna * mutant = mutation.Mutate(dna, config);
+    if (mutant == nullptr) {
+      continue;
+    }
+    ASSERT_EQ(1u, mutation.Edits().size());
+    const Mutation::Edit & edit = mutation.Edits()[0];
+    ASSERT_LE(edit.start + edit.len, int32_t(dna.size()));
+    seen[static_cast<int>(edit.type)]++;
+
+    std::vector<OpCode> expected(dna.begin(), dna.end());
+    switch (edit.type) {
+      case Mutation::Type::INSERT:
+        expected.insert(expected.begin() + edit.start, edit.len, OpCode::NOP);
+        break;
+      case Mutation::Type::DELETE:
+        expected.erase(expected.begin() + edit.start, expected.begin() + edit.start + edit.len);
+        break;
+      case Mutation::Type::CHANGE:
+        // New opcodes are random; check they're valid and keep them
+        for (int32_t j = edit.start; j < edit.start + edit.len; ++j) {
+          EXPECT_GE(static_cast<int32_t>((*mutant)[j]), kOpcodeBegin);
+          EXPECT_LE(static_cast<int32_t>((*mutant)[j]), kOpcodeEnd);
+          expected[j] = (*mutant)[j];
+        }
+        break;
+      case Mutation::Type::TRANSLATE:
+        ASSERT_LE(edit.target + edit.len, int32_t(dna.size()));
+        expected = TranslateInPlace(dna, edit);
+        break;
+    }
+    EXPECT_EQ(expected, std::vector<OpCode>(mutant->begin(), mutant->end()));
+  }
+  for (int type = 0; type < 4; ++type) {
+    EXPECT_LT(0, seen[type]);
+  }
+}
+
+
+TEST(MutationTest, SecondMutationEditsFirst) {
+  Xoshiro256 rng(13);
+  ScopedGenerator sg(rng);
+  // Always two mutations, inserts and deletes changing the size
+  Config config;
+  config.one_mutation = 0;
+  config.two_mutations = 0;
+  Mutation mutation;
+
+  int both = 0;
+  for (int i = 0; i < 5000; ++i) {
+    const Dna dna = RandomDna(rng, 1 + rng.Bounded(40));
+    const Dna * mutant = mutation.Mutate(dna, config);
+    int32_t size = dna.size();
+    for (const Mutation::Edit & edit : mutation.Edits()) {
+      ASSERT_LE(edit.start + edit.len, size);
+      if (edit.type == Mutation::Type::INSERT)
+        size += edit.len;
+      if (edit.type == Mutation::Type::DELETE)
+        size -= edit.len;
+    }
+    if (mutant != nullptr) {
+      EXPECT_EQ(size, int32_t(mutant->size()));
+    }
+    both += mutation.Edits().size() == 2;
+  }
+  EXPECT_LT(0, both);
+}
@@ -0,0 +1,130 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "Asteroid.h"
+#include "Config.h"
+#include "Lifeform.h"
+#include "PausePoint.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+/**
+ * Engines which do nothing but meet at a lockstep asteroid every turn, the
+ * way seeded runs with launch and land intervals of 1 do.
+ */
+class LockstepEngines {
+ public:
+  explicit LockstepEngines(unsigned n)
+      : asteroid_(Config(), n, 1), pause_(n), stop_(false), parked_turns_(n) {
+    asteroid_.SetLockstep();
+    for (auto & t : parked_turns_) {
+      t.store(0);
+    }
+    for (unsigned i = 0; i < n; ++i) {
+      threads_.emplace_back(&LockstepEngines::Run, this, i);
+    }
+  }
+
+  PausePoint & Pause() { return pause_; }
+
+  /**
+   * The turn the given engine last waited at the pause point on.
+   */
+  uint64_t ParkedTurn(unsigned engine) const { return parked_turns_[engine].load(); }
+
+  /**
+   * Stop every engine on the same turn, as StopEngines() in Main.cc does.
+   */
+  void Stop() {
+    pause_.Pause();
+    stop_.store(true);
+    pause_.Resume();
+    for (auto & t : threads_) {
+      t.join();
+    }
+  }
+
+ private:
+  void Run(unsigned engine) {
+    std::vector<Lifeform> migrants;
+    for (uint64_t turn = 0; ; ++turn) {
+      if (pause_.CheckIn(engine, turn)) {
+        parked_turns_[engine].store(turn);
+        pause_.Wait(turn);
+      }
+      if (stop_.load()) {
+        break;
+      }
+      asteroid_.Exchange(engine, migrants, true);
+    }
+    pause_.Leave(engine);
+  }
+
+  Asteroid asteroid_;
+  PausePoint pause_;
+  std::atomic<bool> stop_;
+  std::vector<std::atomic<uint64_t>> parked_turns_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace anon
+
+
+TEST(PausePointTest, PausesLockstepEnginesOnTheSameTurn) {
+  // An engine which checked in just before Pause() is already into its turn,
+  // and stuck at the asteroid until the other gets there too; the pause
+  // turn must be one neither has started
+  LockstepEngines engines(2);
+  uint64_t last_turn = 0;
+  for (int i = 0; i < 2000; ++i) {
+    engines.Pause().Pause();
+    const uint64_t turn = engines.ParkedTurn(0);
+    EXPECT_EQ(turn, engines.ParkedTurn(1)) << "pause " << i;
+    if (i > 0) {
+      EXPECT_GT(turn, last_turn) << "pause " << i;
+    }
+    last_turn = turn;
+    engines.Pause().Resume();
+  }
+  engines.Stop();
+}
+
+
+TEST(PausePointTest, StoppedEnginesAreNotWaitedFor) {
+  PausePoint pause(3);
+  pause.Leave(0);
+  pause.Leave(1);
+
+  std::thread engine([&] {
+    for (uint64_t turn = 10; ; ++turn) {
+      if (pause.CheckIn(2, turn)) {
+        pause.Wait(turn);
+        break;
+      }
+      std::this_thread::yield();
+    }
+    pause.Leave(2);
+  });
+  pause.Pause();
+  pause.Resume();
+  engine.join();
+
+  // With nobody left running, pausing returns at once
+  pause.Pause();
+  pause.Resume();
+}
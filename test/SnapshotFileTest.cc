@@ -0,0 +1,94 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Dna.h"
+#include "LifeformSnapshot.h"
+#include "SnapshotFile.h"
+#include "Types.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+std::string TempFilename() {
+  return "/tmp/evol-snapshot-test-" + std::to_string(getpid());
+}
+
+void AddLifeform(LifeformSnapshot & snapshot, uint64_t id, bool alive, const Dna & dna) {
+  LifeformSnapshot::Record record = {id, id * 2, id * 0.5f, alive, 0, 0};
+  snapshot.Add(record, Span<const OpCode>(dna));
+}
+
+}  // namespace anon
+
+
+TEST(SnapshotFileTest, RoundTrip) {
+  std::vector<LifeformSnapshot> snapshots(3);
+  AddLifeform(snapshots[0], 1, true, Dna{OpCode::FINAL_MOVE_RANDOM});
+  AddLifeform(snapshots[0], 4, false, Dna{OpCode::IS_CROWDED, OpCode::CJMP1, OpCode::APOPTOSIS});
+  // Engine 1 has no lifeforms
+  AddLifeform(snapshots[2], 3, true, Dna{});
+  AddLifeform(snapshots[2], 6, true, Dna{OpCode::NOP, OpCode::FINAL_MOVE_WEST});
+
+  const std::string filename = TempFilename();
+  ASSERT_TRUE(WriteLifeformsSnapshot(snapshots, filename));
+
+  SnapshotReader reader;
+  ASSERT_TRUE(reader.Open(filename));
+  EXPECT_EQ(kSnapshotVersion, reader.Header().version);
+  ASSERT_EQ(3u, reader.Sections().size());
+  ASSERT_EQ(4u, reader.Records().size());
+  EXPECT_EQ(6u, reader.Header().dna_bytes);
+
+  for (uint32_t engine = 0; engine < 3; ++engine) {
+    const SnapshotSection & section = reader.Sections()[engine];
+    EXPECT_EQ(engine, section.engine);
+    ASSERT_EQ(snapshots[engine].Size(), section.num_records);
+    for (size_t i = 0; i < section.num_records; ++i) {
+      const SnapshotRecord & record = reader.Records()[section.first_record + i];
+      const LifeformSnapshot::Record & expected = snapshots[engine].Get(i);
+      EXPECT_EQ(expected.id, record.id);
+      EXPECT_EQ(expected.gen, record.gen);
+      EXPECT_EQ(expected.energy, record.energy);
+      EXPECT_EQ(expected.alive, (record.flags & SnapshotRecord::ALIVE) != 0);
+      Span<const OpCode> dna = reader.GetDna(record), expected_dna = snapshots[engine].GetDna(i);
+      EXPECT_EQ(std::vector<OpCode>(expected_dna.begin(), expected_dna.end()),
+                std::vector<OpCode>(dna.begin(), dna.end()));
+    }
+  }
+
+  reader.Close();
+  remove(filename.c_str());
+}
+
+
+TEST(SnapshotFileTest, RejectsTruncatedFile) {
+  std::vector<LifeformSnapshot> snapshots(1);
+  AddLifeform(snapshots[0], 1, true, Dna{OpCode::JMP2, OpCode::FINAL_MOVE_NORTH});
+
+  const std::string filename = TempFilename();
+  ASSERT_TRUE(WriteLifeformsSnapshot(snapshots, filename));
+  FILE *f = fopen(filename.c_str(), "r+");
+  ASSERT_NE(nullptr, f);
+  fseek(f, 0, SEEK_END);
+  ASSERT_EQ(0, ftruncate(fileno(f), ftell(f) - 1));
+  fclose(f);
+
+  SnapshotReader reader;
+  EXPECT_FALSE(reader.Open(filename));
+  remove(filename.c_str());
+}
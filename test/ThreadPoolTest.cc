@@ -0,0 +1,115 @@
+/*
+ * Evol: The non-life evolution simulator.
+ *
+ * Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+ *
+ * This program is distributed under the terms of the GNU General Public
+ * License Version 3.  See file `COPYING' for details.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "ThreadPool.h"
+#include "gtest/gtest.h"
+
+using namespace evol;
+
+
+namespace {
+
+/**
+ * Run ParallelFor(n, chunk) on the pool and check it visits every index in
+ * [0, n) exactly once.  Spread over helpers, that's in chunks of at most
+ * chunk which start on a multiple of it; otherwise in one go.
+ */
+void ExpectEachIndexOnce(ThreadPool & pool, size_t n, size_t chunk) {
+  std::unique_ptr<std::atomic<int>[]> visits(new std::atomic<int>[n + 1]);
+  for (size_t i = 0; i <= n; ++i) {
+    visits[i] = 0;
+  }
+  const size_t max_chunk = pool.NumThreads() > 1 ? chunk : n;
+  std::atomic<int> bad_chunks(0);
+  auto fn = [&](size_t begin, size_t end) {
+    if (end > n || begin > end || end - begin > std::max(max_chunk, chunk) ||
+        begin % chunk != 0) {
+      ++bad_chunks;
+      return;
+    }
+    for (size_t i = begin; i < end; ++i) {
+      ++visits[i];
+    }
+  };
+  pool.ParallelFor(n, chunk, fn);
+
+  EXPECT_EQ(0, bad_chunks.load()) << "n " << n << ", chunk " << chunk;
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_EQ(1, visits[i].load())
+        << "index " << i << " of n " << n << ", chunk " << chunk
+        << ", threads " << pool.NumThreads();
+  }
+  EXPECT_EQ(0, visits[n].load());
+}
+
+const unsigned kHelpers[] = {0, 1, 3};
+
+}  // namespace anon
+
+
+TEST(ThreadPoolTest, NumThreadsCountsCaller) {
+  for (unsigned helpers : kHelpers) {
+    ThreadPool pool(helpers);
+    EXPECT_EQ(helpers + 1, pool.NumThreads());
+  }
+}
+
+
+TEST(ThreadPoolTest, EmptyRange) {
+  for (unsigned helpers : kHelpers) {
+    ThreadPool pool(helpers);
+    ExpectEachIndexOnce(pool, 0, 16);
+  }
+}
+
+
+TEST(ThreadPoolTest, FewerThanOneChunk) {
+  for (unsigned helpers : kHelpers) {
+    ThreadPool pool(helpers);
+    ExpectEachIndexOnce(pool, 1, 16);
+    ExpectEachIndexOnce(pool, 15, 16);
+    ExpectEachIndexOnce(pool, 16, 16);
+  }
+}
+
+
+TEST(ThreadPoolTest, RaggedLastChunk) {
+  for (unsigned helpers : kHelpers) {
+    ThreadPool pool(helpers);
+    ExpectEachIndexOnce(pool, 17, 16);
+    ExpectEachIndexOnce(pool, 1000, 7);
+    ExpectEachIndexOnce(pool, 4097, 1024);
+    ExpectEachIndexOnce(pool, 100, 1);
+  }
+}
+
+
+TEST(ThreadPoolTest, WholeChunks) {
+  for (unsigned helpers : kHelpers) {
+    ThreadPool pool(helpers);
+    ExpectEachIndexOnce(pool, 64, 16);
+    ExpectEachIndexOnce(pool, 4096, 1024);
+  }
+}
+
+
+TEST(ThreadPoolTest, RepeatedCalls) {
+  // Helpers must pick up each new loop, and not rerun an old one
+  for (unsigned helpers : kHelpers) {
+    ThreadPool pool(helpers);
+    for (size_t i = 0; i < 500; ++i) {
+      ExpectEachIndexOnce(pool, 1 + i * 13 % 300, 1 + i % 9);
+    }
+  }
+}
@@ -0,0 +1,64 @@
+#!/bin/sh
+# Part of Evol: The non-life evolution simulator.
+# Copyright 2014-2018 Eric Barrett <arctil@gmail.com>.
+#
+# This program is distributed under the terms of the GNU General Public
+# License Version 3.  See file `COPYING' for details.
+#
+# Send SIGTERM to a run with the renderer up and check it exits cleanly,
+# leaving a final checkpoint which resumes.  Usage: sigterm-resume.sh [EVOL]
+
+EVOL=${1:-../evol}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+fail() {
+  echo "sigterm-resume: $*" >&2
+  exit 1
+}
+
+# Return the exit status of background process $1, which should be on its
+# way out.  A hang (say a deadlock taking the final checkpoint) is a failure.
+finish() {
+  for _ in 1 2 3 4 5 6 7 8 9 10; do
+    kill -0 $1 2>/dev/null || break
+    sleep 1
+  done
+  if kill -0 $1 2>/dev/null; then
+    kill -KILL $1
+    fail "$2: evol still running after 10s"
+  fi
+  wait $1
+}
+
+# Run with the given extra arguments, SIGTERM it, then resume its final
+# checkpoint.  The periodic checkpoint is far off, so any checkpoint is the
+# one on exit.
+check() {
+  NAME=$1
+  shift
+  CKPT="$DIR/$NAME.ckpt"
+  SETTINGS="--set checkpoint_filename=$CKPT --set checkpoint_interval_seconds=3600
+            --set width=64 --set height=64 --set num_engines=2"
+
+  # Curses draws fine to a file; it only needs to know the terminal type
+  TERM=${TERM:-xterm} $EVOL $SETTINGS "$@" </dev/null >"$DIR/$NAME.out" 2>&1 &
+  PID=$!
+  sleep 2
+  kill -TERM $PID || fail "$NAME: evol exited before SIGTERM"
+  finish $PID "$NAME" || fail "$NAME: evol exited with status $? on SIGTERM"
+  grep -q "Exiting normally" "$DIR/$NAME.out" || fail "$NAME: no clean exit on SIGTERM"
+  [ -s "$CKPT" ] || fail "$NAME: no checkpoint written on SIGTERM"
+
+  $EVOL --resume "$CKPT" --headless --seconds 1 >"$DIR/$NAME-resume.out" 2>&1 &
+  finish $! "$NAME resume" ||
+    fail "$NAME: resume failed: $(cat "$DIR/$NAME-resume.out")"
+  grep -q "Exiting normally" "$DIR/$NAME-resume.out" || fail "$NAME: resumed run didn't exit cleanly"
+}
+
+check free
+# Seeded runs meet at the asteroid in lockstep; with an exchange every turn,
+# pausing for the final checkpoint mustn't leave an engine stuck there
+check seeded --seed 1 --set num_engines=4 --set lifeform_asteroid_launch_interval=1 \
+      --set lifeform_asteroid_land_interval=1
+echo "sigterm-resume: OK"